@@ -0,0 +1,674 @@
+#ifndef ALGORITHM_HPP_INCLUDED_
+#define ALGORITHM_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+#include <detail/algorithm.hpp>
+
+#include <array>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+namespace monad {
+
+    // sequence().  Over contiguous, trivially copyable maybes (and
+    // identities), the states are scanned for the first failure and the
+    // values before it are then copied in bulk.
+    // sequence :: Monad m => [m a] -> m [a]
+    template <
+        typename Iter,
+        typename List = std::vector<
+            detail::list_element_t<typename Iter::value_type::value_type>
+        >,
+        typename State = typename Iter::value_type::state_type
+    >
+    monad<List, State> sequence (Iter first, Iter last)
+    {
+        if constexpr (detail::bulk_sequenceable<Iter, List, State>::value) {
+            if (first != last) {
+                return detail::bulk_sequence_impl<List, State>(
+                    std::addressof(*first),
+                    static_cast<std::size_t>(last - first)
+                );
+            }
+        }
+        return detail::sequence_impl<
+            Iter,
+            typename Iter::value_type,
+            List,
+            State
+        >([](Iter it) {return *it;}, first, last);
+    }
+
+    template <typename Range>
+    auto sequence (Range const & r) ->
+        decltype(sequence(std::begin(r), std::end(r)))
+    { return sequence(std::begin(r), std::end(r)); }
+
+    // sequence() with the List type chosen by ListSelector, e.g.
+    // sequence<small_list<8>>(first, last).
+    template <typename ListSelector, typename Iter>
+    auto sequence (Iter first, Iter last) ->
+        decltype(sequence<
+            Iter,
+            detail::selected_list_t<
+                ListSelector,
+                typename Iter::value_type::value_type
+            >
+        >(first, last))
+    {
+        return sequence<
+            Iter,
+            detail::selected_list_t<
+                ListSelector,
+                typename Iter::value_type::value_type
+            >
+        >(first, last);
+    }
+
+    template <typename ListSelector, typename Range>
+    auto sequence (Range const & r) ->
+        decltype(sequence<ListSelector>(std::begin(r), std::end(r)))
+    { return sequence<ListSelector>(std::begin(r), std::end(r)); }
+
+    // sequence_().  Like sequence(), but the values are discarded; the
+    // result has the same state as that of sequence(first, last).
+    // sequence_ :: Monad m => [m a] -> m ()
+    template <
+        typename Iter,
+        typename State = typename Iter::value_type::state_type
+    >
+    monad<unit, State> sequence_ (Iter first, Iter last)
+    {
+        return detail::sequence_discard_impl<
+            Iter,
+            typename Iter::value_type,
+            State
+        >([](Iter it) {return *it;}, first, last);
+    }
+
+    template <typename Range>
+    auto sequence_ (Range const & r) ->
+        decltype(sequence_(std::begin(r), std::end(r)))
+    { return sequence_(std::begin(r), std::end(r)); }
+
+    // sequence() over a std::array.  The size of the result is known at
+    // compile time, so this overload does not allocate and may be used in
+    // constant expressions.
+    template <typename T, typename State, std::size_t N>
+    constexpr monad<std::array<T, N>, State>
+    sequence (std::array<monad<T, State>, N> const & a)
+    {
+        return detail::array_sequence_impl<
+            monad<T, State>,
+            std::array<T, N>,
+            State
+        >([&a](std::size_t i) {return a[i];});
+    }
+
+    // sequence() over a std::tuple of monads with the same state type.
+    // The result holds a std::tuple of their values.  For short-circuiting
+    // states, all the states are checked before any value is used; if one
+    // fails, the result has the state of the first failure.  Nothing is
+    // allocated.  When t is an rvalue, each value is moved exactly once,
+    // and otherwise each is copied exactly once.
+    template <typename ...Ts, typename State>
+    constexpr monad<std::tuple<Ts...>, State>
+    sequence (std::tuple<monad<Ts, State>...> const & t)
+    {
+        return detail::tuple_sequence_impl<std::tuple<Ts...>, State>(
+            t,
+            std::index_sequence_for<Ts...>{}
+        );
+    }
+
+    template <typename ...Ts, typename State>
+    constexpr monad<std::tuple<Ts...>, State>
+    sequence (std::tuple<monad<Ts, State>...> && t)
+    {
+        return detail::tuple_sequence_impl<std::tuple<Ts...>, State>(
+            t,
+            std::index_sequence_for<Ts...>{}
+        );
+    }
+
+    // Like the std::tuple overload of sequence(), but the values initialize
+    // a T, as with T{values...}, instead of a std::tuple.  T may be an
+    // aggregate, as in sequence_as<record>(std::tuple{m1, m2, m3}).
+    template <typename T, typename ...Ts, typename State>
+    constexpr monad<T, State>
+    sequence_as (std::tuple<monad<Ts, State>...> const & t)
+    {
+        return detail::tuple_sequence_impl<T, State>(
+            t,
+            std::index_sequence_for<Ts...>{}
+        );
+    }
+
+    template <typename T, typename ...Ts, typename State>
+    constexpr monad<T, State>
+    sequence_as (std::tuple<monad<Ts, State>...> && t)
+    {
+        return detail::tuple_sequence_impl<T, State>(
+            t,
+            std::index_sequence_for<Ts...>{}
+        );
+    }
+
+    // traverse().  Like map(), but over the elements of the tuple-like t
+    // (a std::tuple, std::pair, std::array, or any type that supports
+    // structured bindings through std::tuple_size and get()), which may
+    // have different types.  f may therefore be overloaded or generic; all
+    // the monads it returns must have the same state type.  f is applied
+    // to every element, in order, and the result is that of sequence() on
+    // the std::tuple of the monads it returns.
+    // traverse :: (Traversable t, Monad m) => (a -> m b) -> t a -> m (t b)
+    template <typename Fn, typename Tuple>
+    constexpr auto traverse (Fn f, Tuple && t) ->
+        decltype(sequence(detail::tuple_map_impl(
+            f,
+            std::forward<Tuple>(t),
+            detail::tuple_indices_t<Tuple>{}
+        )))
+    {
+        return sequence(detail::tuple_map_impl(
+            f,
+            std::forward<Tuple>(t),
+            detail::tuple_indices_t<Tuple>{}
+        ));
+    }
+
+    // Like traverse(), but the values initialize a T, as with
+    // sequence_as<T>().
+    template <typename T, typename Fn, typename Tuple>
+    constexpr auto traverse_as (Fn f, Tuple && t) ->
+        decltype(sequence_as<T>(detail::tuple_map_impl(
+            f,
+            std::forward<Tuple>(t),
+            detail::tuple_indices_t<Tuple>{}
+        )))
+    {
+        return sequence_as<T>(detail::tuple_map_impl(
+            f,
+            std::forward<Tuple>(t),
+            detail::tuple_indices_t<Tuple>{}
+        ));
+    }
+
+    // mapM().  Fn must have a signature of the form
+    // monad<...> (typename Iter::value_type), and may return a reference
+    // to a monad, e.g. to one within the element.  With std::identity as
+    // Fn, this is sequence(first, last), including its bulk path.
+    // mapM :: Monad m => (a -> m b) -> [a] -> m [b]
+    template <
+        typename Fn,
+        typename Iter,
+        typename List = std::vector<
+            detail::list_element_t<detail::mapped_value_type_t<Fn, Iter>>
+        >
+    >
+    auto map (Fn f, Iter first, Iter last) ->
+        monad<List, detail::state_type_t<decltype(f(*first))>>
+    {
+        using monad_type = typename std::decay<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        if constexpr (detail::is_identity<Fn>::value) {
+            return sequence<Iter, List, state_type>(first, last);
+        } else {
+            return detail::sequence_impl<Iter, monad_type, List, state_type>(
+                [f](Iter it) {return f(*it);},
+                first,
+                last
+            );
+        }
+    }
+
+    template <typename Fn, typename Range>
+    auto map (Fn f, Range const & r) ->
+        decltype(map(f, std::begin(r), std::end(r)))
+    { return map(f, std::begin(r), std::end(r)); }
+
+    // map() with the List type chosen by ListSelector, e.g.
+    // map<small_list<8>>(f, r).
+    template <typename ListSelector, typename Fn, typename Iter>
+    auto map (Fn f, Iter first, Iter last) ->
+        decltype(map<
+            Fn,
+            Iter,
+            detail::selected_list_t<
+                ListSelector,
+                detail::mapped_value_type_t<Fn, Iter>
+            >
+        >(f, first, last))
+    {
+        return map<
+            Fn,
+            Iter,
+            detail::selected_list_t<
+                ListSelector,
+                detail::mapped_value_type_t<Fn, Iter>
+            >
+        >(f, first, last);
+    }
+
+    template <typename ListSelector, typename Fn, typename Range>
+    auto map (Fn f, Range const & r) ->
+        decltype(map<ListSelector>(f, std::begin(r), std::end(r)))
+    { return map<ListSelector>(f, std::begin(r), std::end(r)); }
+
+    // mapM_().  Like map(), but the values are discarded, so nothing is
+    // allocated; the result has the same state as that of
+    // map(f, first, last).  For short-circuiting states, f is not called
+    // on the elements after the first failure.
+    // mapM_ :: Monad m => (a -> m b) -> [a] -> m ()
+    template <typename Fn, typename Iter>
+    auto map_ (Fn f, Iter first, Iter last) ->
+        monad<unit, detail::state_type_t<decltype(f(*first))>>
+    {
+        using monad_type = typename std::remove_cv<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        return detail::sequence_discard_impl<Iter, monad_type, state_type>(
+            [f](Iter it) {return f(*it);},
+            first,
+            last
+        );
+    }
+
+    template <typename Fn, typename Range>
+    auto map_ (Fn f, Range const & r) ->
+        decltype(map_(f, std::begin(r), std::end(r)))
+    { return map_(f, std::begin(r), std::end(r)); }
+
+    // forM_().  map_() with its arguments flipped.
+    // forM_ :: Monad m => [a] -> (a -> m b) -> m ()
+    template <typename Iter, typename Fn>
+    auto for_ (Iter first, Iter last, Fn f) -> decltype(map_(f, first, last))
+    { return map_(f, first, last); }
+
+    template <typename Range, typename Fn>
+    auto for_ (Range const & r, Fn f) -> decltype(map_(f, r))
+    { return map_(f, r); }
+
+    // map() over a std::array.  Like the std::array overload of sequence(),
+    // this does not allocate and may be used in constant expressions.
+    template <typename Fn, typename A, std::size_t N>
+    constexpr auto map (Fn f, std::array<A, N> const & a) ->
+        monad<
+            std::array<typename decltype(f(a[0]))::value_type, N>,
+            detail::state_type_t<
+                typename std::remove_cv<decltype(f(a[0]))>::type
+            >
+        >
+    {
+        using monad_type = typename std::remove_cv<decltype(f(a[0]))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using array_type =
+            std::array<typename monad_type::value_type, N>;
+        return detail::array_sequence_impl<monad_type, array_type, state_type>(
+            [f, &a](std::size_t i) {return f(a[i]);}
+        );
+    }
+
+    // mapAndUnzipM().  Fn must have a signature of the form
+    // monad<std::pair<...>, ...> (typename Iter::value_type).
+    // mapAndUnzipM :: (Monad m) => (a -> m (b,c)) -> [a] -> m ([b], [c])
+    template <
+        typename Fn,
+        typename Iter,
+        typename FirstList = std::vector<
+            typename detail::mapped_value_type_t<Fn, Iter>::first_type
+        >,
+        typename SecondList = std::vector<
+            typename detail::mapped_value_type_t<Fn, Iter>::second_type
+        >
+    >
+    auto map_unzip (Fn f, Iter first, Iter last) ->
+        monad<
+            std::pair<FirstList, SecondList>,
+            detail::state_type_t<decltype(f(*first))>
+        >
+    {
+        using monad_type = typename std::remove_cv<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using result_type = monad<std::pair<FirstList, SecondList>, state_type>;
+
+        if (first == last)
+            return result_type{};
+
+        auto mapped = map(f, first, last);
+        using mapped_type = decltype(mapped);
+        return mapped >>= [mapped](typename mapped_type::value_type mapped_list) {
+            std::size_t size = mapped_list.size();
+            std::pair<FirstList, SecondList> data;
+            data.first.reserve(size);
+            data.second.reserve(size);
+            for (auto x : mapped_list) {
+                data.first.push_back(x.first);
+                data.second.push_back(x.second);
+            }
+            return result_type{data, mapped.state()};
+        };
+    }
+
+    template <typename Fn, typename Range>
+    auto map_unzip (Fn f, Range const & r) ->
+        decltype(map_unzip(f, std::begin(r), std::end(r)))
+    { return map_unzip(f, std::begin(r), std::end(r)); }
+
+    // filterM().  Predicate Fn must have a signature of the form
+    // monad<bool, ...> (typename Iter::value_type).
+    // filterM :: Monad m => (a -> m Bool) -> [a] -> m [a]
+    template <
+        typename Fn,
+        typename Iter,
+        typename List = std::vector<typename Iter::value_type>
+    >
+    auto filter (Fn f, Iter first, Iter last) ->
+        monad<List, detail::state_type_t<decltype(f(*first))>>
+    {
+        using monad_type = typename std::remove_cv<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using result_type = monad<List, state_type>;
+
+        result_type retval;
+
+        if (first == last)
+            return retval;
+
+        detail::reserve(retval.mutable_value(), first, last);
+
+        if constexpr (monad_traits<state_type>::state_independent_of_values) {
+            using traits = monad_traits<state_type>;
+            monad_type m = f(*first);
+            state_type state = m.state();
+            while (!traits::failed(state)) {
+                if (m.value())
+                    retval.mutable_value().push_back(*first);
+                if (++first == last)
+                    break;
+                m = f(*first);
+                state = traits::combine(state, m.state());
+            }
+            retval.mutable_state() = state;
+        } else {
+            auto prev_value = *first;
+            monad_type prev = f(prev_value);
+            ++first;
+
+            while (first != last) {
+                auto value = *first;
+                monad_type m = f(value);
+                ++first;
+                prev = prev >>= [=, &retval](bool b) {
+                    if (b)
+                        retval.mutable_value().push_back(prev_value);
+                    return m;
+                };
+                prev_value = value;
+            }
+
+            prev >>= [=, &retval](bool b) {
+                if (b)
+                    retval.mutable_value().push_back(prev_value);
+                return prev;
+            };
+
+            retval.mutable_state() = prev.state();
+        }
+
+        return retval;
+    }
+
+    template <typename Fn, typename Range>
+    auto filter (Fn f, Range const & r) ->
+        decltype(filter(f, std::begin(r), std::end(r)))
+    { return filter(f, std::begin(r), std::end(r)); }
+
+    // filter() with the List type chosen by ListSelector, e.g.
+    // filter<small_list<8>>(f, r).
+    template <typename ListSelector, typename Fn, typename Iter>
+    auto filter (Fn f, Iter first, Iter last) ->
+        decltype(filter<
+            Fn,
+            Iter,
+            detail::selected_list_t<
+                ListSelector,
+                typename std::iterator_traits<Iter>::value_type
+            >
+        >(f, first, last))
+    {
+        return filter<
+            Fn,
+            Iter,
+            detail::selected_list_t<
+                ListSelector,
+                typename std::iterator_traits<Iter>::value_type
+            >
+        >(f, first, last);
+    }
+
+    template <typename ListSelector, typename Fn, typename Range>
+    auto filter (Fn f, Range const & r) ->
+        decltype(filter<ListSelector>(f, std::begin(r), std::end(r)))
+    { return filter<ListSelector>(f, std::begin(r), std::end(r)); }
+
+    // zipWithM().  Fn must have a signature of the form
+    // monad<...> (typename Iter1::value_type, typename Iter2::value_type).
+    // zipWithM :: (Monad m) => (a -> b -> m c) -> [a] -> [b] -> m [c]
+    template <
+        typename Fn,
+        typename Iter1,
+        typename Iter2,
+        typename List = std::vector<
+            detail::list_element_t<detail::zip_value_type_t<Fn, Iter1, Iter2>>
+        >
+    >
+    auto zip (Fn f, Iter1 first1, Iter1 last1, Iter2 first2) ->
+        monad<List, detail::state_type_t<decltype(f(*first1, *first2))>>
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(f(*first1, *first2))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using zip_iter = detail::zip_iterator<Iter1, Iter2>;
+        zip_iter first{first1, first2};
+        zip_iter last{last1, first2};
+        return detail::sequence_impl<zip_iter, monad_type, List, state_type>(
+            [f](zip_iter it) {return f(*it.first, *it.second);},
+            first,
+            last
+        );
+    }
+
+    template <typename Fn, typename Range1, typename Range2>
+    auto zip (Fn f, Range1 const & r1, Range2 const & r2) ->
+        decltype(zip(f, std::begin(r1), std::end(r1), std::begin(r2)))
+    { return zip(f, std::begin(r1), std::end(r1), std::begin(r2)); }
+
+    // zip() with the List type chosen by ListSelector, e.g.
+    // zip<small_list<8>>(f, r1, r2).
+    template <typename ListSelector, typename Fn, typename Iter1, typename Iter2>
+    auto zip (Fn f, Iter1 first1, Iter1 last1, Iter2 first2) ->
+        decltype(zip<
+            Fn,
+            Iter1,
+            Iter2,
+            detail::selected_list_t<
+                ListSelector,
+                detail::zip_value_type_t<Fn, Iter1, Iter2>
+            >
+        >(f, first1, last1, first2))
+    {
+        return zip<
+            Fn,
+            Iter1,
+            Iter2,
+            detail::selected_list_t<
+                ListSelector,
+                detail::zip_value_type_t<Fn, Iter1, Iter2>
+            >
+        >(f, first1, last1, first2);
+    }
+
+    template <typename ListSelector, typename Fn, typename Range1, typename Range2>
+    auto zip (Fn f, Range1 const & r1, Range2 const & r2) ->
+        decltype(zip<ListSelector>(f, std::begin(r1), std::end(r1), std::begin(r2)))
+    { return zip<ListSelector>(f, std::begin(r1), std::end(r1), std::begin(r2)); }
+
+    // zip() over two std::arrays of the same size.  Like the std::array
+    // overload of map(), this does not allocate and may be used in
+    // constant expressions.
+    template <typename Fn, typename A, typename B, std::size_t N>
+    constexpr auto zip (
+        Fn f,
+        std::array<A, N> const & a,
+        std::array<B, N> const & b
+    ) ->
+        monad<
+            std::array<typename decltype(f(a[0], b[0]))::value_type, N>,
+            detail::state_type_t<
+                typename std::remove_cv<decltype(f(a[0], b[0]))>::type
+            >
+        >
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(f(a[0], b[0]))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using array_type =
+            std::array<typename monad_type::value_type, N>;
+        return detail::array_sequence_impl<monad_type, array_type, state_type>(
+            [f, &a, &b](std::size_t i) {return f(a[i], b[i]);}
+        );
+    }
+
+    // zipWithM_().  Like zip(), but the values are discarded, so nothing is
+    // allocated; the result has the same state as that of
+    // zip(f, first1, last1, first2).
+    // zipWithM_ :: (Monad m) => (a -> b -> m c) -> [a] -> [b] -> m ()
+    template <typename Fn, typename Iter1, typename Iter2>
+    auto zip_ (Fn f, Iter1 first1, Iter1 last1, Iter2 first2) ->
+        monad<unit, detail::state_type_t<decltype(f(*first1, *first2))>>
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(f(*first1, *first2))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using zip_iter = detail::zip_iterator<Iter1, Iter2>;
+        zip_iter first{first1, first2};
+        zip_iter last{last1, first2};
+        return detail::sequence_discard_impl<zip_iter, monad_type, state_type>(
+            [f](zip_iter it) {return f(*it.first, *it.second);},
+            first,
+            last
+        );
+    }
+
+    template <typename Fn, typename Range1, typename Range2>
+    auto zip_ (Fn f, Range1 const & r1, Range2 const & r2) ->
+        decltype(zip_(f, std::begin(r1), std::end(r1), std::begin(r2)))
+    { return zip_(f, std::begin(r1), std::end(r1), std::begin(r2)); }
+
+    // foldM().  Fn must have a signature of the form
+    // monad<T, ...> (T, typename Iter::value_type::value_type).
+    // foldM :: (Monad m) => (a -> b -> m a) -> a -> [b] -> m a
+    template <typename Fn, typename T, typename Iter>
+    constexpr auto fold (Fn f, T initial_value, Iter first, Iter last) ->
+        typename std::remove_cv<decltype(f(initial_value, *first))>::type
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(f(initial_value, *first))>::type;
+        using value_type = typename monad_type::value_type;
+        using state_type = typename monad_type::state_type;
+
+        if (first == last)
+            return monad_type{};
+
+        monad_type retval = f(initial_value, *first++);
+
+        if constexpr (monad_traits<state_type>::state_independent_of_values) {
+            using traits = monad_traits<state_type>;
+            while (first != last && !traits::failed(retval.state())) {
+                state_type const state = retval.state();
+                retval = f(std::move(retval).value(), *first++);
+                retval.mutable_state() = traits::combine(state, retval.state());
+            }
+        } else {
+            while (first != last) {
+                auto y = *first++;
+                retval = retval >>= [f, y](value_type x) {
+                    return f(x, y);
+                };
+            }
+        }
+
+        return retval;
+    }
+
+    template <typename Fn, typename T, typename Range>
+    constexpr auto fold (Fn f, T initial_value, Range const & r) ->
+        decltype(fold(f, initial_value, std::begin(r), std::end(r)))
+    { return fold(f, initial_value, std::begin(r), std::end(r)); }
+
+    // replicateM_().  The same as sequence_() over a list of n copies of
+    // m, but without creating the copies.
+    // replicateM_ :: (Monad m) => Int -> m a -> m ()
+    template <typename T, typename State>
+    monad<unit, State> replicate_ (std::size_t n, monad<T, State> m)
+    {
+        if (!n)
+            return monad<unit, State>{};
+
+        using traits = monad_traits<State>;
+
+        if constexpr (traits::state_independent_of_values) {
+            State state = m.state();
+            for (std::size_t i = 1; i < n && !traits::failed(state); ++i) {
+                state = traits::combine(state, m.state());
+            }
+            return monad<unit, State>{unit{}, state};
+        } else {
+            monad<T, State> prev = m;
+            if (!traits::short_circuits) {
+                for (std::size_t i = 1; i < n; ++i) {
+                    prev = prev >>= [m](T const &) {
+                        return m;
+                    };
+                }
+            }
+            return monad<unit, State>{unit{}, prev.state()};
+        }
+    }
+
+    // replicateM().  The same as sequence() over a list of n copies of m,
+    // but without creating the copies.  The result's list is reserved to
+    // exactly n elements when List supports reserve().
+    // replicateM :: (Monad m) => Int -> m a -> m [a]
+    template <
+        typename T,
+        typename State,
+        typename List = std::vector<detail::list_element_t<T>>
+    >
+    monad<List, State> replicate (std::size_t n, monad<T, State> m)
+    {
+        if (!n)
+            return monad<List, State>{};
+
+        monad<List, State> retval{List{}, m.state()};
+
+        if (monad_traits<State>::failed(m.state()))
+            return retval;
+
+        detail::reserve_n(retval.mutable_value(), n);
+        for (std::size_t i = 0; i < n; ++i) {
+            retval.mutable_value().push_back(m.value());
+        }
+
+        retval.mutable_state() = replicate_(n, m).state();
+
+        return retval;
+    }
+
+}
+
+#endif
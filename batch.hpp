@@ -0,0 +1,387 @@
+#ifndef BATCH_HPP_INCLUDED_
+#define BATCH_HPP_INCLUDED_
+
+#include <maybe/maybe.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
+
+namespace monad {
+
+#if defined(__cpp_lib_span)
+
+    template <typename T>
+    using span = std::span<T>;
+
+#else
+
+    /** A pointer and a size; std::span, where that is not available. */
+    template <typename T>
+    class span
+    {
+    public:
+        using element_type = T;
+        using value_type = typename std::remove_cv<T>::type;
+        using iterator = T *;
+
+        constexpr span () :
+            data_ (nullptr),
+            size_ (0)
+        {}
+
+        constexpr span (T * data, std::size_t size) :
+            data_ (data),
+            size_ (size)
+        {}
+
+        constexpr T * data () const
+        { return data_; }
+
+        constexpr std::size_t size () const
+        { return size_; }
+
+        constexpr bool empty () const
+        { return !size_; }
+
+        constexpr T & operator[] (std::size_t i) const
+        { return data_[i]; }
+
+        constexpr iterator begin () const
+        { return data_; }
+
+        constexpr iterator end () const
+        { return data_ + size_; }
+
+    private:
+        T * data_;
+        std::size_t size_;
+    };
+
+#endif
+
+    /** Execution policy requesting that an algorithm pass its input to a
+        batch kernel in chunks of @c chunk_size elements.  A @c chunk_size
+        of 0 means as many elements as fit in 16KB, so that a chunk of input
+        and its outputs stay in the L1 cache. */
+    struct batched_policy
+    {
+        std::size_t chunk_size;
+    };
+
+    inline constexpr batched_policy batched = {0};
+
+    namespace detail {
+
+        template <typename T>
+        std::size_t chunk_size (batched_policy policy)
+        {
+            if (policy.chunk_size)
+                return policy.chunk_size;
+            std::size_t const retval = 16384 / sizeof(T);
+            return retval ? retval : 1;
+        }
+
+        template <typename Range>
+        using range_element_t = typename std::remove_cv<
+            typename std::remove_reference<
+                decltype(*std::data(std::declval<Range const &>()))
+            >::type
+        >::type;
+
+        // The element type of the I-th parameter of Kernel, which must be
+        // a span.
+        template <typename Kernel, std::size_t I>
+        using kernel_output_t = typename std::remove_cv<
+            typename std::tuple_element<
+                I,
+                typename callable_params<Kernel>::type
+            >::type::element_type
+        >::type;
+
+        inline bool all_valid (bool const * valid, std::size_t n)
+        { return std::find(valid, valid + n, false) == valid + n; }
+
+        // The state of one element of a kernel's span of flags: a bool is
+        // maybe's state, and any other flag is a state itself.
+        inline maybe_state flag_state (bool valid)
+        { return maybe_state{valid}; }
+
+        template <typename State>
+        State const & flag_state (State const & state)
+        { return state; }
+
+        template <typename Flag>
+        using flag_state_t = typename std::decay<
+            decltype(flag_state(std::declval<Flag const &>()))
+        >::type;
+
+        // The value of each flag before a kernel sets it: true, or a
+        // value-initialized state.
+        template <typename Flag>
+        Flag initial_flag ()
+        {
+            if constexpr (std::is_same<Flag, bool>::value)
+                return true;
+            else
+                return Flag{};
+        }
+
+        // Combines the states of flags[first, n) into state.  Returns
+        // false if the result is a failure that ends the computation.
+        template <typename State, typename Flag>
+        bool combine_flags (
+            State & state,
+            Flag const * flags,
+            std::size_t first,
+            std::size_t n
+        ) {
+            using traits = monad_traits<State>;
+            if constexpr (std::is_same<Flag, bool>::value) {
+                // Combining successes leaves maybe's state unchanged.
+                if (all_valid(flags + first, n - first))
+                    return !traits::failed(state);
+            }
+            for (std::size_t i = first; i < n && !traits::failed(state); ++i) {
+                state = traits::combine(state, flag_state(flags[i]));
+            }
+            return !traits::failed(state);
+        }
+
+        // The values a kernel writes, in a std::vector<T> that it writes
+        // in place, or, for bool, whose std::vector has no data(), in an
+        // array that is copied into one at the end.
+        template <typename T>
+        class batch_output
+        {
+        public:
+            explicit batch_output (std::size_t size) :
+                values_ (size)
+            {}
+
+            T * data ()
+            { return values_.data(); }
+
+            std::vector<T> release ()
+            { return std::move(values_); }
+
+        private:
+            std::vector<T> values_;
+        };
+
+        template <>
+        class batch_output<bool>
+        {
+        public:
+            explicit batch_output (std::size_t size) :
+                values_ (new bool[size]),
+                size_ (size)
+            {}
+
+            bool * data ()
+            { return values_.get(); }
+
+            std::vector<bool> release ()
+            { return std::vector<bool>(values_.get(), values_.get() + size_); }
+
+        private:
+            std::unique_ptr<bool[]> values_;
+            std::size_t size_;
+        };
+
+        // The result of a batched map() or zip() whose kernel stopped at a
+        // failure with state state.
+        template <typename Result, typename State>
+        Result failed_batch (State const & state)
+        {
+            Result retval;
+            retval.mutable_state() = state;
+            return retval;
+        }
+
+    }
+
+    // mapM() over contiguous memory, in batches.  kernel must have a
+    // signature of the form
+    // void (span<A const> in, span<B> out, span<Flag> flags),
+    // and must write the result for in[i] to out[i], and its state to
+    // flags[i].  Flag is either bool, for maybe, in which case the kernel
+    // sets flags[i] to false if there is no result, and the flags are all
+    // true on entry; or a state whose monad_traits set
+    // state_independent_of_values, in which case the flags are
+    // value-initialized on entry.  The result is the same as that of map()
+    // with the per-element function the kernel implements: the states are
+    // combined in order, and for short-circuiting states, no chunks are
+    // passed to kernel after the first that contains a failure.
+    template <typename Kernel, typename Range>
+    auto map (batched_policy policy, Kernel kernel, Range const & r) ->
+        monad<
+            std::vector<detail::kernel_output_t<Kernel, 1>>,
+            detail::flag_state_t<detail::kernel_output_t<Kernel, 2>>
+        >
+    {
+        using in_type = detail::range_element_t<Range>;
+        using out_type = detail::kernel_output_t<Kernel, 1>;
+        using flag_type = detail::kernel_output_t<Kernel, 2>;
+        using state_type = detail::flag_state_t<flag_type>;
+        using result_type = monad<std::vector<out_type>, state_type>;
+        static_assert(
+            monad_traits<state_type>::state_independent_of_values,
+            "A batched kernel's states must combine independently of the "
+            "values."
+        );
+
+        std::size_t const size = std::size(r);
+        if (!size)
+            return result_type{};
+
+        in_type const * const data = std::data(r);
+        std::size_t const chunk = detail::chunk_size<in_type>(policy);
+        detail::batch_output<out_type> out(size);
+        std::unique_ptr<flag_type[]> flags(new flag_type[std::min(chunk, size)]);
+        state_type state;
+
+        for (std::size_t i = 0; i < size; i += chunk) {
+            std::size_t const n = std::min(chunk, size - i);
+            std::fill_n(flags.get(), n, detail::initial_flag<flag_type>());
+            kernel(
+                span<in_type const>(data + i, n),
+                span<out_type>(out.data() + i, n),
+                span<flag_type>(flags.get(), n)
+            );
+            if (!i)
+                state = detail::flag_state(flags[0]);
+            if (!detail::combine_flags(state, flags.get(), i ? 0 : 1, n))
+                return detail::failed_batch<result_type>(state);
+        }
+
+        return result_type{out.release(), state};
+    }
+
+    // zipWithM() over contiguous memory, in batches.  kernel must have a
+    // signature of the form
+    // void (span<A const> in1, span<B const> in2, span<C> out,
+    //       span<Flag> flags),
+    // and otherwise behaves as the kernel passed to the batched map().
+    // r2 must have at least as many elements as r1.
+    template <typename Kernel, typename Range1, typename Range2>
+    auto zip (
+        batched_policy policy,
+        Kernel kernel,
+        Range1 const & r1,
+        Range2 const & r2
+    ) -> monad<
+        std::vector<detail::kernel_output_t<Kernel, 2>>,
+        detail::flag_state_t<detail::kernel_output_t<Kernel, 3>>
+    >
+    {
+        using in1_type = detail::range_element_t<Range1>;
+        using in2_type = detail::range_element_t<Range2>;
+        using out_type = detail::kernel_output_t<Kernel, 2>;
+        using flag_type = detail::kernel_output_t<Kernel, 3>;
+        using state_type = detail::flag_state_t<flag_type>;
+        using result_type = monad<std::vector<out_type>, state_type>;
+        static_assert(
+            monad_traits<state_type>::state_independent_of_values,
+            "A batched kernel's states must combine independently of the "
+            "values."
+        );
+
+        std::size_t const size = std::size(r1);
+        if (!size)
+            return result_type{};
+
+        in1_type const * const data1 = std::data(r1);
+        in2_type const * const data2 = std::data(r2);
+        std::size_t const chunk = detail::chunk_size<
+            typename std::conditional<
+                sizeof(in2_type) < sizeof(in1_type),
+                in1_type,
+                in2_type
+            >::type
+        >(policy);
+        detail::batch_output<out_type> out(size);
+        std::unique_ptr<flag_type[]> flags(new flag_type[std::min(chunk, size)]);
+        state_type state;
+
+        for (std::size_t i = 0; i < size; i += chunk) {
+            std::size_t const n = std::min(chunk, size - i);
+            std::fill_n(flags.get(), n, detail::initial_flag<flag_type>());
+            kernel(
+                span<in1_type const>(data1 + i, n),
+                span<in2_type const>(data2 + i, n),
+                span<out_type>(out.data() + i, n),
+                span<flag_type>(flags.get(), n)
+            );
+            if (!i)
+                state = detail::flag_state(flags[0]);
+            if (!detail::combine_flags(state, flags.get(), i ? 0 : 1, n))
+                return detail::failed_batch<result_type>(state);
+        }
+
+        return result_type{out.release(), state};
+    }
+
+    // foldM() over contiguous memory, in batches.  kernel must have a
+    // signature of the form monad<T, State> (T acc, span<A const> in),
+    // where State's monad_traits set state_independent_of_values, and
+    // must fold the elements of in onto acc.  The result's state is the
+    // combination of the states of the calls, and its value is that of the
+    // last call; for short-circuiting states, no calls are made after a
+    // failure.  The result is value-initialized (nothing, for maybe) if r
+    // is empty.
+    template <typename Kernel, typename T, typename Range>
+    auto fold (batched_policy policy, Kernel kernel, T initial_value, Range const & r) ->
+        typename std::remove_cv<
+            decltype(kernel(initial_value, span<detail::range_element_t<Range> const>()))
+        >::type
+    {
+        using in_type = detail::range_element_t<Range>;
+        using result_type = typename std::remove_cv<
+            decltype(kernel(initial_value, span<in_type const>()))
+        >::type;
+        using state_type = typename result_type::state_type;
+        using traits = monad_traits<state_type>;
+        static_assert(
+            traits::state_independent_of_values,
+            "A batched kernel's states must combine independently of the "
+            "values."
+        );
+
+        std::size_t const size = std::size(r);
+        if (!size)
+            return result_type{};
+
+        in_type const * const data = std::data(r);
+        std::size_t const chunk = detail::chunk_size<in_type>(policy);
+
+        result_type retval = kernel(
+            std::move(initial_value),
+            span<in_type const>(data, std::min(chunk, size))
+        );
+        for (std::size_t i = chunk; i < size && !traits::failed(retval.state()); i += chunk) {
+            std::size_t const n = std::min(chunk, size - i);
+            state_type const state = retval.state();
+            retval = kernel(std::move(retval).value(), span<in_type const>(data + i, n));
+            retval.mutable_state() = traits::combine(state, retval.state());
+        }
+
+        return retval;
+    }
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+// Compares map(), zip() and fold() with a cheap per-element function to
+// their batched overloads with an equivalent kernel, on 1M ints.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -march=native -I. bench/batch.cpp -o bench_batch
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "batch.hpp"
+#include "bench/harness.hpp"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+    using monad::maybe;
+    using monad::span;
+
+    constexpr std::size_t size = 1 << 20;
+
+    maybe<int> scale (int x)
+    { return x < 0 ? maybe<int>{monad::nothing} : maybe<int>{3 * x + 1}; }
+
+    void scale_kernel (span<int const> in, span<int> out, span<bool> valid)
+    {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = 3 * in[i] + 1;
+            valid[i] = 0 <= in[i];
+        }
+    }
+
+    maybe<int> difference (int x, int y)
+    { return x < y ? maybe<int>{monad::nothing} : maybe<int>{x - y}; }
+
+    void difference_kernel (
+        span<int const> lhs,
+        span<int const> rhs,
+        span<int> out,
+        span<bool> valid
+    ) {
+        for (std::size_t i = 0; i < lhs.size(); ++i) {
+            out[i] = lhs[i] - rhs[i];
+            valid[i] = rhs[i] <= lhs[i];
+        }
+    }
+
+    maybe<long> add (long acc, int x)
+    { return x < 0 ? maybe<long>{monad::nothing} : maybe<long>{acc + x}; }
+
+    maybe<long> add_kernel (long acc, span<int const> in)
+    {
+        bool ok = true;
+        for (int x : in) {
+            acc += x;
+            ok &= 0 <= x;
+        }
+        return ok ? maybe<long>{acc} : maybe<long>{monad::nothing};
+    }
+
+}
+
+int main ()
+{
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> dist(1000, 1 << 20);
+    std::vector<int> lhs(size);
+    std::vector<int> rhs(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        lhs[i] = dist(gen);
+        rhs[i] = lhs[i] - dist(gen) % 1000;
+    }
+
+    bench::run("map, per element", size, 21, [&] {
+        bench::do_not_optimize(monad::map(scale, lhs));
+    });
+    bench::run("map, batched", size, 21, [&] {
+        bench::do_not_optimize(monad::map(monad::batched, scale_kernel, lhs));
+    });
+
+    bench::run("zip, per element", size, 21, [&] {
+        bench::do_not_optimize(monad::zip(difference, lhs, rhs));
+    });
+    bench::run("zip, batched", size, 21, [&] {
+        bench::do_not_optimize(monad::zip(monad::batched, difference_kernel, lhs, rhs));
+    });
+
+    bench::run("fold, per element", size, 21, [&] {
+        bench::do_not_optimize(monad::fold(add, 0l, lhs));
+    });
+    bench::run("fold, batched", size, 21, [&] {
+        bench::do_not_optimize(monad::fold(monad::batched, add_kernel, 0l, lhs));
+    });
+
+    if (monad::map(scale, lhs) != monad::map(monad::batched, scale_kernel, lhs) ||
+        monad::zip(difference, lhs, rhs) != monad::zip(monad::batched, difference_kernel, lhs, rhs) ||
+        monad::fold(add, 0l, lhs) != monad::fold(monad::batched, add_kernel, 0l, lhs)) {
+        std::printf("MISMATCH\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Compares sequence() over a std::vector<maybe<int>>, which scans the
+// states and then copies the values in bulk, to the element-by-element
+// path it took before, at 1K, 1M and 100M elements, with every element
+// present and with the only failure in the last element.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/bulk_sequence.cpp -o bench_bulk_sequence
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "bench/harness.hpp"
+
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    using monad::maybe;
+
+    using iterator = std::vector<maybe<int>>::const_iterator;
+
+    monad::monad<std::vector<int>, monad::detail::maybe_state>
+    generic_sequence (std::vector<maybe<int>> const & monads)
+    {
+        return monad::detail::sequence_impl<
+            iterator,
+            maybe<int>,
+            std::vector<int>,
+            monad::detail::maybe_state
+        >([](iterator it) {return *it;}, monads.begin(), monads.end());
+    }
+
+}
+
+int main ()
+{
+    for (std::size_t size : {std::size_t(1000), std::size_t(1) << 20, std::size_t(100000000)}) {
+        int const iterations = size < 1000000 ? 10001 : size < 10000000 ? 101 : 5;
+        std::string const suffix = ", " + std::to_string(size);
+
+        std::vector<maybe<int>> monads(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            monads[i] = maybe<int>{static_cast<int>(i)};
+        }
+
+        bench::run(("generic" + suffix).c_str(), size, iterations, [&] {
+            bench::do_not_optimize(generic_sequence(monads));
+        });
+        bench::run(("bulk" + suffix).c_str(), size, iterations, [&] {
+            bench::do_not_optimize(monad::sequence(monads));
+        });
+
+        monads.back() = monad::nothing;
+        bench::run(("generic, last failed" + suffix).c_str(), size, iterations, [&] {
+            bench::do_not_optimize(generic_sequence(monads));
+        });
+        bench::run(("bulk, last failed" + suffix).c_str(), size, iterations, [&] {
+            bench::do_not_optimize(monad::sequence(monads));
+        });
+    }
+    return 0;
+}
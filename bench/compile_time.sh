@@ -0,0 +1,102 @@
+#!/bin/sh
+# Measures the per-translation-unit cost of including the library's headers.
+# For each case below, a one-function TU is compiled several times with
+# GCC's -ftime-report, and the median parse time, template instantiation
+# time and total wall time are printed.
+#
+# Usage (from the repository root):
+#     bench/compile_time.sh [runs]
+# CXX and CXXFLAGS are honored; the default is g++ -std=c++17 -O2.
+
+set -e
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2}
+RUNS=${1:-5}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Prints the median of the numbers on stdin.
+median () {
+    sort -n | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+# Prints the wall time of the -ftime-report line starting with $1, read
+# from stdin.  The columns are usr, sys, wall and GGC, each but the last
+# optionally followed by a parenthesized percentage.  Phases too short to
+# be reported count as 0.
+wall_time () {
+    awk -v key="$1" -F: '
+        $1 ~ "^ *" key " *$" {
+            gsub(/\([^)]*\)/, "", $2)
+            split($2, f, " ")
+            print f[3]
+            found = 1
+        }
+        END { if (!found) print "0.00" }'
+}
+
+# measure NAME: compiles $WORK/NAME.cpp $RUNS times.
+measure () {
+    : > "$WORK/parse"
+    : > "$WORK/instantiate"
+    : > "$WORK/total"
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        $CXX $CXXFLAGS -I"$ROOT" -ftime-report -c "$WORK/$1.cpp" \
+            -o "$WORK/$1.o" 2> "$WORK/report"
+        wall_time 'phase parsing' < "$WORK/report" >> "$WORK/parse"
+        wall_time 'template instantiation' < "$WORK/report" >> "$WORK/instantiate"
+        wall_time 'TOTAL' < "$WORK/report" >> "$WORK/total"
+        i=$((i + 1))
+    done
+    printf '%-28s parse %6ss   instantiate %6ss   total %6ss\n' "$1" \
+        "$(median < "$WORK/parse")" \
+        "$(median < "$WORK/instantiate")" \
+        "$(median < "$WORK/total")"
+}
+
+cat > "$WORK/maybe_fwd.cpp" <<'CPP'
+#include <maybe/maybe_fwd.hpp>
+int f (monad::maybe<int> const & m);
+CPP
+
+cat > "$WORK/maybe.cpp" <<'CPP'
+#include <maybe/maybe.hpp>
+monad::maybe<int> f (monad::maybe<int> m)
+{ return m >>= [](int x) {return monad::maybe<int>{x + 1};}; }
+CPP
+
+cat > "$WORK/maybe_lift_n.cpp" <<'CPP'
+#include <maybe/maybe.hpp>
+monad::maybe<int> f (monad::maybe<int> a, monad::maybe<int> b, monad::maybe<int> c)
+{
+    return monad::lift_n<monad::maybe<int>>(
+        [](int x, int y, int z) {return x + y + z;}, a, b, c
+    );
+}
+CPP
+
+cat > "$WORK/maybe_algorithm.cpp" <<'CPP'
+#include <maybe/maybe.hpp>
+#include <algorithm.hpp>
+monad::maybe<std::vector<int>> f (std::vector<monad::maybe<int>> const & v)
+{ return monad::sequence(v); }
+CPP
+
+cat > "$WORK/monad.cpp" <<'CPP'
+#include <maybe/maybe.hpp>
+#include <monad.hpp>
+#include <parallel.hpp>
+monad::maybe<int> f (std::vector<int> const & v)
+{
+    return monad::reduce(
+        monad::seq, [](int x, int y) {return monad::maybe<int>{x + y};}, 0, v
+    );
+}
+CPP
+
+for name in maybe_fwd maybe maybe_lift_n maybe_algorithm monad; do
+    measure $name
+done
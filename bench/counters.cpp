@@ -0,0 +1,108 @@
+// Runs sequence(), filter(), fold(), lift_n() and a chain of >>= over 1M
+// maybes, so that the hardware counters show whether each is limited by
+// branch mispredictions on the state, by cache misses, or by neither.
+// lift_n() and the >>= chain are also run on inputs whose states fail at
+// random; the algorithms would stop at the first of these.
+// Run with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/counters.cpp -o bench_counters
+//     BENCH_COUNTERS=1 BENCH_FORMAT=json ./bench_counters > counters.json
+// Where the counters cannot be read (e.g. perf_event_paranoid is too high,
+// or in a VM without a PMU), they are reported as null.
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "bench/harness.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    using monad::maybe;
+
+    constexpr std::size_t size = 1 << 20;
+
+    maybe<int> add_one (int x)
+    { return x < 1000000 ? maybe<int>{x + 1} : maybe<int>{monad::nothing}; }
+
+    void run_algorithms (std::vector<maybe<int>> const & monads)
+    {
+        std::vector<int> values(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            values[i] = monads[i].value();
+        }
+
+        bench::run("sequence", size, 11, [&] {
+            bench::do_not_optimize(monad::sequence(monads));
+        });
+
+        // The predicate's value is unpredictable.
+        auto is_odd = [](int x) {
+            return x < 0 ? maybe<bool>{monad::nothing} : maybe<bool>{x % 2 != 0};
+        };
+        bench::run("filter", size, 11, [&] {
+            bench::do_not_optimize(monad::filter(is_odd, values));
+        });
+
+        auto add = [](long acc, int x) {
+            return x < 0 ? maybe<long>{monad::nothing} : maybe<long>{acc + x};
+        };
+        bench::run("fold", size, 11, [&] {
+            bench::do_not_optimize(monad::fold(add, 0l, values));
+        });
+    }
+
+    void run_per_element (char const * inputs, std::vector<maybe<int>> const & monads)
+    {
+        std::string const suffix = std::string(", ") + inputs;
+
+        bench::run(("lift_n" + suffix).c_str(), size, 11, [&] {
+            int sum = 0;
+            for (std::size_t i = 0; i + 2 < size; ++i) {
+                maybe<int> const m = monad::lift_n<maybe<int>>(
+                    [](int a, int b, int c) {return a + b - c;},
+                    monads[i],
+                    monads[i + 1],
+                    monads[i + 2]
+                );
+                sum += m.state().nonempty_;
+            }
+            bench::do_not_optimize(sum);
+        });
+
+        bench::run(("bind chain" + suffix).c_str(), size, 11, [&] {
+            int sum = 0;
+            for (maybe<int> const & m : monads) {
+                maybe<int> const result =
+                    (((m >>= add_one) >>= add_one) >>= add_one) >>= add_one;
+                sum += result.state().nonempty_;
+            }
+            bench::do_not_optimize(sum);
+        });
+    }
+
+}
+
+int main ()
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 999);
+
+    std::vector<maybe<int>> monads(size);
+    for (auto & m : monads) {
+        m = maybe<int>{dist(gen)};
+    }
+    run_algorithms(monads);
+    run_per_element("all valid", monads);
+
+    // Half the states fail, at random.
+    for (auto & m : monads) {
+        if (dist(gen) < 500)
+            m = monad::nothing;
+    }
+    run_per_element("half failed", monads);
+
+    return 0;
+}
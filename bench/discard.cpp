@@ -0,0 +1,44 @@
+// Compares a validation pass written with map(), which builds and discards
+// a vector of results, with the same pass written with map_().
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/discard.cpp -o bench_discard
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "bench/harness.hpp"
+
+
+int main ()
+{
+    auto validate = [](int x) {
+        return 0 <= x ? monad::maybe<int>{x} : monad::maybe<int>{monad::nothing};
+    };
+
+    std::size_t const size = 10 * 1000 * 1000;
+    std::vector<int> values(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        values[i] = i % 1000;
+    }
+
+    int const iterations = 5;
+
+    bench::run("map (validation)", size, iterations, [&] {
+        bench::do_not_optimize(monad::map(validate, values).state());
+    });
+
+    bench::run("map_ (validation)", size, iterations, [&] {
+        bench::do_not_optimize(monad::map_(validate, values).state());
+    });
+
+    std::vector<monad::maybe<int>> maybes(values.begin(), values.end());
+
+    bench::run("sequence (validation)", size, iterations, [&] {
+        bench::do_not_optimize(monad::sequence(maybes).state());
+    });
+
+    bench::run("sequence_ (validation)", size, iterations, [&] {
+        bench::do_not_optimize(monad::sequence_(maybes).state());
+    });
+
+    return 0;
+}
@@ -0,0 +1,311 @@
+#ifndef BENCH_HARNESS_HPP_INCLUDED_
+#define BENCH_HARNESS_HPP_INCLUDED_
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace bench {
+
+    // Keeps the compiler from discarding a computed value.
+    template <typename T>
+    void do_not_optimize (T const & value)
+    { asm volatile("" : : "r,m"(value) : "memory"); }
+
+    /** How run() reports its results, as chosen by the environment:
+        BENCH_COUNTERS=1 also reads the hardware counters around each run
+        and reports their per-element rates, and BENCH_FORMAT=json prints
+        one JSON object per benchmark, one per line, instead of a table. */
+    struct options
+    {
+        bool counters;
+        bool json;
+    };
+
+    inline options const & get_options ()
+    {
+        static options const retval = [] {
+            char const * counters = std::getenv("BENCH_COUNTERS");
+            char const * format = std::getenv("BENCH_FORMAT");
+            return options{
+                counters && *counters && std::strcmp(counters, "0") != 0,
+                format && std::strcmp(format, "json") == 0
+            };
+        }();
+        return retval;
+    }
+
+    /** The hardware counters read around each run.  They are opened as
+        one group, so that they are all counted over the same intervals.
+        On systems without perf_event_open(), or where it is not permitted,
+        a counter is reported as unavailable rather than failing the
+        benchmark. */
+    class counters
+    {
+    public:
+        static constexpr int size = 5;
+
+        static char const * name (int i)
+        {
+            static char const * const names[size] = {
+                "cycles",
+                "instructions",
+                "branch_misses",
+                "l1d_read_misses",
+                "llc_read_misses"
+            };
+            return names[i];
+        }
+
+        counters ()
+        {
+#if defined(__linux__)
+            int error = 0;
+            std::uint64_t const cache_read_miss =
+                (std::uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) |
+                (std::uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+            std::uint32_t const types[size] = {
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HW_CACHE,
+                PERF_TYPE_HW_CACHE
+            };
+            std::uint64_t const configs[size] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_BRANCH_MISSES,
+                PERF_COUNT_HW_CACHE_L1D | cache_read_miss,
+                PERF_COUNT_HW_CACHE_LL | cache_read_miss
+            };
+            // The first counter that opens leads the group; the group is
+            // enabled, disabled and read through it.
+            for (int i = 0; i < size; ++i) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = types[i];
+                attr.config = configs[i];
+                attr.disabled = leader_ < 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format =
+                    PERF_FORMAT_GROUP |
+                    PERF_FORMAT_TOTAL_TIME_ENABLED |
+                    PERF_FORMAT_TOTAL_TIME_RUNNING;
+                int const fd = static_cast<int>(
+                    syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0)
+                );
+                if (fd < 0) {
+                    if (!error)
+                        error = errno;
+                    continue;
+                }
+                if (leader_ < 0)
+                    leader_ = fd;
+                fds_[i] = fd;
+                slots_[i] = members_++;
+            }
+            if (error) {
+                std::fprintf(
+                    stderr,
+                    "bench: some hardware counters are unavailable: %s\n",
+                    std::strerror(error)
+                );
+            }
+#else
+            std::fprintf(
+                stderr,
+                "bench: hardware counters are not supported on this platform\n"
+            );
+#endif
+        }
+
+        counters (counters const &) = delete;
+        counters & operator= (counters const &) = delete;
+
+        ~counters ()
+        {
+#if defined(__linux__)
+            for (int fd : fds_) {
+                if (0 <= fd)
+                    close(fd);
+            }
+#endif
+        }
+
+        void start ()
+        {
+#if defined(__linux__)
+            if (0 <= leader_) {
+                ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#endif
+        }
+
+        // Stops counting, adds the counts since start() to totals, and
+        // increments runs for each counter that was counted.  Nothing is
+        // counted if the group was never scheduled on the hardware, e.g.
+        // because other events occupied it for the whole run.
+        void stop (double (&totals)[size], int (&runs)[size])
+        {
+#if defined(__linux__)
+            if (leader_ < 0)
+                return;
+            ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            // The number of counters, the time enabled, the time running,
+            // and the counters' values.  When the group is multiplexed,
+            // the values are scaled up to the whole time enabled.
+            std::uint64_t values[3 + size];
+            ssize_t const bytes = (3 + members_) * sizeof(std::uint64_t);
+            if (read(leader_, values, bytes) != bytes || !values[2])
+                return;
+            for (int i = 0; i < size; ++i) {
+                if (slots_[i] < 0)
+                    continue;
+                totals[i] += double(values[3 + slots_[i]]) * values[1] / values[2];
+                ++runs[i];
+            }
+#else
+            (void)totals;
+            (void)runs;
+#endif
+        }
+
+    private:
+        int fds_[size] = {-1, -1, -1, -1, -1};
+        // The index of each counter's value in a read of the group, or -1.
+        int slots_[size] = {-1, -1, -1, -1, -1};
+        int leader_ = -1;
+        int members_ = 0;
+    };
+
+    // The counters, or null if BENCH_COUNTERS is not set.
+    inline counters * get_counters ()
+    {
+        if (!get_options().counters)
+            return nullptr;
+        static counters retval;
+        return &retval;
+    }
+
+    namespace detail {
+
+        inline std::string json_string (char const * s)
+        {
+            std::string retval = "\"";
+            for (; *s; ++s) {
+                if (*s == '"' || *s == '\\')
+                    retval += '\\';
+                retval += *s;
+            }
+            return retval += '"';
+        }
+
+    }
+
+    /** Runs @c f @c iterations times and prints the median wall-clock time
+        of a single run, and that time divided by @c elements.  If
+        BENCH_COUNTERS is set, also prints the mean of each hardware counter
+        over the runs in which it was counted, divided by @c elements, or
+        "n/a" (null in JSON) if it was counted in none. */
+    template <typename Fn>
+    double run (char const * name, std::size_t elements, int iterations, Fn f)
+    {
+        options const & opts = get_options();
+        counters * const counters_ = get_counters();
+        double totals[counters::size] = {};
+        int counted_runs[counters::size] = {};
+
+        std::vector<double> times;
+        times.reserve(iterations);
+        for (int i = 0; i < iterations; ++i) {
+            if (counters_)
+                counters_->start();
+            auto const start = std::chrono::steady_clock::now();
+            f();
+            auto const stop = std::chrono::steady_clock::now();
+            if (counters_)
+                counters_->stop(totals, counted_runs);
+            times.push_back(
+                std::chrono::duration<double, std::milli>(stop - start).count()
+            );
+        }
+        std::sort(times.begin(), times.end());
+        double const median = times[times.size() / 2];
+        double const per_element = elements ? median * 1.0e6 / elements : 0.0;
+        // The mean of counter i per element, over the runs in which it
+        // was counted.
+        auto per_element_count = [&](int i) {
+            return totals[i] / (double(counted_runs[i]) * (elements ? elements : 1));
+        };
+
+        if (opts.json) {
+            std::printf(
+                "{\"name\": %s, \"elements\": %zu, \"iterations\": %d, "
+                "\"median_ms\": %.6f, \"ns_per_element\": %.6f",
+                detail::json_string(name).c_str(),
+                elements,
+                iterations,
+                median,
+                per_element
+            );
+            if (counters_) {
+                std::printf(", \"per_element\": {");
+                for (int i = 0; i < counters::size; ++i) {
+                    std::printf("%s\"%s\": ", i ? ", " : "", counters::name(i));
+                    if (counted_runs[i])
+                        std::printf("%.6f", per_element_count(i));
+                    else
+                        std::printf("null");
+                }
+                std::printf("}");
+            }
+            std::printf("}\n");
+        } else {
+            std::printf(
+                "%-40s %10.3f ms %10.3f ns/element\n",
+                name,
+                median,
+                per_element
+            );
+            if (counters_) {
+                for (int i = 0; i < counters::size; ++i) {
+                    if (counted_runs[i]) {
+                        std::printf(
+                            "    %-36s %10.3f /element\n",
+                            counters::name(i),
+                            per_element_count(i)
+                        );
+                    } else {
+                        std::printf(
+                            "    %-36s %10s\n",
+                            counters::name(i),
+                            "n/a"
+                        );
+                    }
+                }
+            }
+        }
+        std::fflush(stdout);
+        return median;
+    }
+
+}
+
+#endif
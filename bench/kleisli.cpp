@@ -0,0 +1,97 @@
+// Compares a 5-stage compose_k() pipeline with the same stages written as
+// nested >>= lambdas and as a hand-written if chain.  composed_5() and
+// if_chain_5() are kept out of line so their code can be compared with
+// e.g.:
+//     g++ -std=c++17 -O3 -I. -S bench/kleisli.cpp -o - | c++filt
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/kleisli.cpp -o bench_kleisli
+
+#include "maybe/maybe.hpp"
+#include "bench/harness.hpp"
+
+
+namespace {
+
+    monad::maybe<int> stage_1 (int x)
+    { return 0 < x ? monad::maybe<int>{x - 1} : monad::nothing; }
+
+    monad::maybe<int> stage_2 (int x)
+    { return x % 3 ? monad::maybe<int>{x * 2} : monad::nothing; }
+
+    monad::maybe<int> stage_3 (int x)
+    { return x < (1 << 28) ? monad::maybe<int>{x + 7} : monad::nothing; }
+
+    monad::maybe<int> stage_4 (int x)
+    { return x & 1 ? monad::maybe<int>{x ^ 4} : monad::nothing; }
+
+    monad::maybe<int> stage_5 (int x)
+    { return x != 42 ? monad::maybe<int>{x / 3} : monad::nothing; }
+
+    auto const pipeline = monad::compose_k(
+        [](int x) {return stage_1(x);},
+        [](int x) {return stage_2(x);},
+        [](int x) {return stage_3(x);},
+        [](int x) {return stage_4(x);},
+        [](int x) {return stage_5(x);}
+    );
+
+}
+
+__attribute__((noinline)) monad::maybe<int> composed_5 (int x)
+{ return pipeline(x); }
+
+__attribute__((noinline)) monad::maybe<int> nested_5 (int x)
+{
+    return stage_1(x) >>= [](int a) {
+        return stage_2(a) >>= [](int b) {
+            return stage_3(b) >>= [](int c) {
+                return stage_4(c) >>= [](int d) {
+                    return stage_5(d);
+                };
+            };
+        };
+    };
+}
+
+__attribute__((noinline)) monad::maybe<int> if_chain_5 (int x)
+{
+    auto a = stage_1(x);
+    if (!a.state().nonempty_)
+        return monad::nothing;
+    auto b = stage_2(a.value());
+    if (!b.state().nonempty_)
+        return monad::nothing;
+    auto c = stage_3(b.value());
+    if (!c.state().nonempty_)
+        return monad::nothing;
+    auto d = stage_4(c.value());
+    if (!d.state().nonempty_)
+        return monad::nothing;
+    return stage_5(d.value());
+}
+
+int main ()
+{
+    int const size = 100 * 1000 * 1000;
+    int const iterations = 5;
+
+    bench::run("compose_k, 5 stages", size, iterations, [&] {
+        for (int i = 0; i < size; ++i) {
+            bench::do_not_optimize(composed_5(i));
+        }
+    });
+
+    bench::run("nested >>=, 5 stages", size, iterations, [&] {
+        for (int i = 0; i < size; ++i) {
+            bench::do_not_optimize(nested_5(i));
+        }
+    });
+
+    bench::run("if chain, 5 stages", size, iterations, [&] {
+        for (int i = 0; i < size; ++i) {
+            bench::do_not_optimize(if_chain_5(i));
+        }
+    });
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Compares an expensive parse-and-validate function with its memoized
+// version on keys drawn from a Zipf distribution (s = 1.0) over 1M distinct
+// keys, for a few cache capacities.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/memoize.cpp -pthread -o bench_memoize
+
+#include "maybe/maybe.hpp"
+#include "memoize.hpp"
+#include "bench/harness.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+
+namespace {
+
+    // Parses a decimal integer, then does some work standing in for a
+    // validation lookup.
+    monad::maybe<long> parse_and_validate (std::string const & s)
+    {
+        long x = 0;
+        for (char c : s) {
+            if (c < '0' || '9' < c)
+                return monad::nothing;
+            x = x * 10 + (c - '0');
+        }
+        unsigned long h = x;
+        for (int i = 0; i < 500; ++i) {
+            h = h * 6364136223846793005ul + 1442695040888963407ul;
+        }
+        return h % 7 ? monad::maybe<long>{x} : monad::maybe<long>{monad::nothing};
+    }
+
+    // Applies f to each key with >>=, and counts the successes.
+    template <typename Fn>
+    std::size_t count_valid (Fn f, std::vector<std::string> const & keys)
+    {
+        std::size_t retval = 0;
+        for (auto const & key : keys) {
+            auto const m = monad::maybe<std::string>{key} >>= f;
+            retval += m.state().nonempty_;
+        }
+        return retval;
+    }
+
+    std::vector<std::string> zipf_keys (std::size_t count, std::size_t distinct)
+    {
+        std::vector<double> cdf(distinct);
+        double sum = 0.0;
+        for (std::size_t i = 0; i < distinct; ++i) {
+            sum += 1.0 / (i + 1);
+            cdf[i] = sum;
+        }
+
+        std::mt19937_64 gen(42);
+        std::uniform_real_distribution<double> dist(0.0, sum);
+        std::vector<std::string> retval(count);
+        for (auto & key : retval) {
+            std::size_t const rank =
+                std::lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin();
+            key = std::to_string(rank * 7919 % distinct);
+        }
+        return retval;
+    }
+
+}
+
+int main ()
+{
+    std::size_t const size = 2 * 1000 * 1000;
+    std::vector<std::string> const keys = zipf_keys(size, 1000 * 1000);
+
+    int const iterations = 3;
+
+    bench::run("not memoized", size, iterations, [&] {
+        bench::do_not_optimize(count_valid(parse_and_validate, keys));
+    });
+
+    for (std::size_t capacity : {1000u, 10000u, 100000u}) {
+        auto const memo = monad::memoize(parse_and_validate, capacity);
+        std::string const name =
+            "memoized, capacity " + std::to_string(capacity);
+        bench::run(name.c_str(), size, iterations, [&] {
+            bench::do_not_optimize(count_valid(memo, keys));
+        });
+        auto const stats = memo.stats();
+        std::printf(
+            "  hit rate %.3f, %zu evictions\n",
+            stats.hit_rate(),
+            stats.evictions
+        );
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Measures sequence(), filter() and fold() over 1M elements for maybe,
+// identity, and a user-defined monad that gets the algorithms' loop paths
+// through its monad_traits specialization alone.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/monad_traits.cpp -o bench_monad_traits
+
+#include "maybe/maybe.hpp"
+#include "identity.hpp"
+#include "algorithm.hpp"
+#include "bench/harness.hpp"
+
+#include <vector>
+
+
+namespace {
+
+    // The number of checks made, and whether they all passed.
+    struct checked_state
+    {
+        long checks = 0;
+        bool ok = true;
+    };
+
+}
+
+namespace monad {
+
+    template <>
+    struct monad_traits<checked_state> : default_monad_traits<checked_state>
+    {
+        static constexpr bool short_circuits = true;
+
+        static constexpr bool failed (checked_state state)
+        { return !state.ok; }
+
+        static constexpr bool state_independent_of_values = true;
+        static constexpr bool associative_combine = true;
+
+        static constexpr checked_state combine (checked_state lhs, checked_state rhs)
+        { return {lhs.checks + rhs.checks, lhs.ok && rhs.ok}; }
+    };
+
+}
+
+namespace {
+
+    template <typename T>
+    using checked = monad::monad<T, checked_state>;
+
+    constexpr std::size_t size = 1 << 20;
+
+    template <template <typename> class M, typename MakeState>
+    void run_all (char const * name, MakeState make_state)
+    {
+        std::vector<int> values(size);
+        std::vector<M<int>> monads(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            values[i] = static_cast<int>(i % 1000);
+            monads[i] = M<int>{values[i], make_state(values[i])};
+        }
+
+        auto is_even = [&](int x) {
+            return M<bool>{x % 2 == 0, make_state(x)};
+        };
+        auto add = [&](long acc, int x) {
+            return M<long>{acc + x, make_state(x)};
+        };
+
+        std::string label;
+        label = std::string("sequence, ") + name;
+        bench::run(label.c_str(), size, 21, [&] {
+            bench::do_not_optimize(monad::sequence(monads));
+        });
+        label = std::string("filter, ") + name;
+        bench::run(label.c_str(), size, 21, [&] {
+            bench::do_not_optimize(monad::filter(is_even, values));
+        });
+        label = std::string("fold, ") + name;
+        bench::run(label.c_str(), size, 21, [&] {
+            bench::do_not_optimize(monad::fold(add, 0l, values));
+        });
+    }
+
+}
+
+int main ()
+{
+    run_all<monad::maybe>("maybe", [](int x) {
+        return monad::detail::maybe_state{0 <= x};
+    });
+    run_all<monad::identity>("identity", [](int) {
+        return monad::detail::identity_state{};
+    });
+    run_all<checked>("user monad", [](int x) {
+        return checked_state{1, 0 <= x};
+    });
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Compares the lifted operators of declare_operators.hpp to the nested
+// binds they replace: element-wise + and * over vectors of 1M maybe<int>,
+// and repeated += on a maybe<std::string>.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -march=native -I. bench/operators.cpp -o bench_operators
+
+#include "maybe/maybe.hpp"
+#include "declare_operators.hpp"
+#include "bench/harness.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    using monad::maybe;
+
+    constexpr std::size_t size = 1 << 20;
+
+    // What the old MONAD_BINARY_OP() macro generated.
+    template <typename T, typename Op>
+    maybe<T> bind_op (maybe<T> lhs, maybe<T> rhs, Op op)
+    {
+        return lhs >>= [rhs, op](T x) {
+            return rhs >>= [x, op](T y) {
+                return maybe<T>{op(x, y)};
+            };
+        };
+    }
+
+    template <typename Op>
+    std::vector<maybe<int>> bind_elementwise (
+        std::vector<maybe<int>> const & lhs,
+        std::vector<maybe<int>> const & rhs,
+        Op op
+    ) {
+        std::vector<maybe<int>> retval;
+        retval.reserve(lhs.size());
+        for (std::size_t i = 0; i < lhs.size(); ++i) {
+            retval.push_back(bind_op(lhs[i], rhs[i], op));
+        }
+        return retval;
+    }
+
+}
+
+int main ()
+{
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    std::vector<maybe<int>> lhs(size);
+    std::vector<maybe<int>> rhs(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        int const x = dist(gen);
+        int const y = dist(gen);
+        lhs[i] = x % 10 ? maybe<int>{x} : maybe<int>{monad::nothing};
+        rhs[i] = y % 10 ? maybe<int>{y} : maybe<int>{monad::nothing};
+    }
+
+    bench::run("+, nested binds", size, 21, [&] {
+        bench::do_not_optimize(bind_elementwise(lhs, rhs, std::plus<>{}));
+    });
+    bench::run("+, element-wise", size, 21, [&] {
+        bench::do_not_optimize(lhs + rhs);
+    });
+    bench::run("*, nested binds", size, 21, [&] {
+        bench::do_not_optimize(bind_elementwise(lhs, rhs, std::multiplies<>{}));
+    });
+    bench::run("*, element-wise", size, 21, [&] {
+        bench::do_not_optimize(lhs * rhs);
+    });
+
+    if (bind_elementwise(lhs, rhs, std::plus<>{}) != lhs + rhs)
+        std::printf("MISMATCH\n");
+
+    constexpr std::size_t appends = 1 << 14;
+    maybe<std::string> const piece{std::string(32, 'x')};
+    bench::run("string append, nested binds", appends, 11, [&] {
+        maybe<std::string> s{std::string()};
+        for (std::size_t i = 0; i < appends; ++i) {
+            s = bind_op(s, piece, std::plus<>{});
+        }
+        bench::do_not_optimize(s);
+    });
+    bench::run("string append, +=", appends, 11, [&] {
+        maybe<std::string> s{std::string()};
+        for (std::size_t i = 0; i < appends; ++i) {
+            s += piece;
+        }
+        bench::do_not_optimize(s);
+    });
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Compares a parser built from the combinators in parser.hpp with a
+// hand-written one, on CSV-like records of the form "id,name,x,y\n".  The
+// input is 1 GB by default; pass a size in MB to change it.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/parser.cpp -o bench_parser
+
+#include "parser.hpp"
+#include "bench/harness.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+
+namespace {
+
+    struct record
+    {
+        int id;
+        std::string_view name;
+        int x;
+        int y;
+    };
+
+    // A container that only accumulates what is pushed into it, so that
+    // the parsers' own costs are what is measured.
+    struct totals
+    {
+        void push_back (record const & r)
+        {
+            ++records;
+            sum += r.id + r.x - r.y;
+            name_bytes += r.name.size();
+        }
+
+        std::size_t records = 0;
+        long long sum = 0;
+        std::size_t name_bytes = 0;
+    };
+
+    std::string make_input (std::size_t bytes)
+    {
+        std::string retval;
+        retval.reserve(bytes + 64);
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<int> value(-100000, 100000);
+        std::uniform_int_distribution<int> name_length(3, 12);
+        int id = 0;
+        while (retval.size() < bytes) {
+            retval += std::to_string(id++);
+            retval += ',';
+            retval.append(name_length(gen), 'a' + id % 26);
+            retval += ',';
+            retval += std::to_string(value(gen));
+            retval += ',';
+            retval += std::to_string(value(gen));
+            retval += '\n';
+        }
+        return retval;
+    }
+
+    totals parse_monadic (std::string_view input)
+    {
+        auto const comma = monad::char_(',');
+        auto const name = monad::take_while([](char c) {return c != ',';});
+        auto const record_ = monad::lift_n<monad::parsed<record>>(
+            [](int id, std::string_view n, int x, int y) {
+                return record{id, n, x, y};
+            },
+            monad::int_ << comma,
+            name << comma,
+            monad::int_ << comma,
+            monad::int_ << monad::char_('\n')
+        );
+
+        totals retval;
+        auto const result = monad::many(record_, retval)(input);
+        if (!result.state().ok || !result.state().rest.empty())
+            std::abort();
+        return retval;
+    }
+
+    totals parse_by_hand (std::string_view input)
+    {
+        totals retval;
+        char const * first = input.data();
+        char const * const last = first + input.size();
+
+        auto int_ = [&](int & x) {
+            auto const result = std::from_chars(first, last, x);
+            if (result.ec != std::errc())
+                std::abort();
+            first = result.ptr;
+        };
+        auto expect = [&](char c) {
+            if (first == last || *first != c)
+                std::abort();
+            ++first;
+        };
+
+        while (first != last) {
+            record r;
+            int_(r.id);
+            expect(',');
+            char const * const name_first = first;
+            while (first != last && *first != ',') {
+                ++first;
+            }
+            r.name = std::string_view(name_first, first - name_first);
+            expect(',');
+            int_(r.x);
+            expect(',');
+            int_(r.y);
+            expect('\n');
+            retval.push_back(r);
+        }
+        return retval;
+    }
+
+}
+
+int main (int argc, char * argv[])
+{
+    std::size_t const megabytes = 1 < argc ? std::atoi(argv[1]) : 1024;
+    std::string const input = make_input(megabytes << 20);
+    std::size_t const records = parse_by_hand(input).records;
+
+    std::printf("%zu records, %zu bytes\n", records, input.size());
+
+    totals monadic;
+    totals by_hand;
+    double const monadic_ms = bench::run("parser combinators", records, 5, [&] {
+        monadic = parse_monadic(input);
+        bench::do_not_optimize(monadic);
+    });
+    double const by_hand_ms = bench::run("hand-written", records, 5, [&] {
+        by_hand = parse_by_hand(input);
+        bench::do_not_optimize(by_hand);
+    });
+
+    if (monadic.sum != by_hand.sum || monadic.name_bytes != by_hand.name_bytes)
+        std::printf("MISMATCH\n");
+
+    std::printf(
+        "parser combinators %.2f GB/s, hand-written %.2f GB/s\n",
+        input.size() / monadic_ms / 1.0e6,
+        input.size() / by_hand_ms / 1.0e6
+    );
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Compares running three stages of different cost one element at a time on
+// one thread with running them as a pipeline, one thread per stage.  With
+// enough cores, the pipeline's time should approach that of its slowest
+// stage rather than the sum of all three.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/pipeline.cpp -pthread -o bench_pipeline
+
+#include "maybe/maybe.hpp"
+#include "pipeline.hpp"
+#include "bench/harness.hpp"
+
+#include <cstdio>
+
+
+namespace {
+
+    // Stands in for a stage doing work proportional to n.
+    unsigned long spin (unsigned long x, int n)
+    {
+        for (int i = 0; i < n; ++i) {
+            x = x * 6364136223846793005ul + 1442695040888963407ul;
+        }
+        return x;
+    }
+
+}
+
+int main ()
+{
+    auto decode = [](unsigned long x) {
+        return monad::maybe<unsigned long>{spin(x, 200)};
+    };
+    auto validate = [](unsigned long x) {
+        return x % 16 ?
+            monad::maybe<unsigned long>{spin(x, 400)} :
+            monad::maybe<unsigned long>{monad::nothing};
+    };
+    auto enrich = [](unsigned long x) {
+        return monad::maybe<unsigned long>{spin(x, 300)};
+    };
+
+    std::size_t const size = 1000 * 1000;
+    std::vector<unsigned long> inputs(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        inputs[i] = i;
+    }
+
+    int const iterations = 3;
+
+    auto const composed = monad::compose_k(decode, validate, enrich);
+    bench::run("one thread, 3 stages", size, iterations, [&] {
+        unsigned long sum = 0;
+        for (auto x : inputs) {
+            auto const m = composed(x);
+            if (m.state().nonempty_)
+                sum += m.value();
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    auto const p = monad::make_pipeline(1024, composed);
+    monad::pipeline_stats stats;
+    bench::run("pipeline, 3 stages", size, iterations, [&] {
+        unsigned long sum = 0;
+        stats = p.run(inputs, [&sum](unsigned long x) {sum += x;});
+        bench::do_not_optimize(sum);
+    });
+
+    for (std::size_t i = 0; i < stats.stages.size(); ++i) {
+        std::printf(
+            "  stage %zu: %zu processed, %zu rejected, %.0f/s\n",
+            i,
+            stats.stages[i].processed,
+            stats.stages[i].rejected,
+            stats.stages[i].throughput()
+        );
+    }
+    std::printf(
+        "  overall: %.0f/s\n",
+        stats.seconds ? stats.inputs / stats.seconds : 0.0
+    );
+
+    return 0;
+}
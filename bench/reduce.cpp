@@ -0,0 +1,51 @@
+// Compares fold() with sequential and parallel reduce() on a checked sum.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/reduce.cpp -pthread -o bench_reduce
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "parallel.hpp"
+#include "bench/harness.hpp"
+
+#include <climits>
+#include <string>
+
+
+int main ()
+{
+    auto checked_sum = [](long lhs, long rhs) {
+        return rhs <= LONG_MAX - lhs ?
+            monad::maybe<long>{lhs + rhs} :
+            monad::maybe<long>{monad::nothing};
+    };
+
+    std::size_t const size = 50 * 1000 * 1000;
+    std::vector<long> values(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        values[i] = i % 1000;
+    }
+
+    int const iterations = 5;
+
+    bench::run("fold", size, iterations, [&] {
+        bench::do_not_optimize(monad::fold(checked_sum, 0, values));
+    });
+
+    bench::run("reduce(seq)", size, iterations, [&] {
+        bench::do_not_optimize(monad::reduce(monad::seq, checked_sum, 0, values));
+    });
+
+    std::size_t const max_threads = monad::detail::thread_count(monad::par);
+    for (std::size_t threads = 1;; threads = std::min(threads * 2, max_threads)) {
+        monad::parallel_policy policy = {threads, 4096};
+        std::string const name =
+            "reduce(par), " + std::to_string(threads) + " thread(s)";
+        bench::run(name.c_str(), size, iterations, [&] {
+            bench::do_not_optimize(monad::reduce(policy, checked_sum, 0, values));
+        });
+        if (threads == max_threads)
+            break;
+    }
+
+    return 0;
+}
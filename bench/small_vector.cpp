@@ -0,0 +1,110 @@
+// Compares map(), filter() and sequence() over short (2 to 8 element)
+// inputs with the default std::vector result to the same calls with
+// small_list<8>, and counts the heap allocations each makes.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/small_vector.cpp -o bench_small_vector
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "small_vector.hpp"
+#include "bench/harness.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+    std::size_t allocations = 0;
+
+}
+
+void * operator new (std::size_t size)
+{
+    ++allocations;
+    if (void * p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete (void * p) noexcept
+{ std::free(p); }
+
+void operator delete (void * p, std::size_t) noexcept
+{ std::free(p); }
+
+namespace {
+
+    using monad::maybe;
+
+    maybe<int> checked_double (int x)
+    { return x < 0 ? maybe<int>{monad::nothing} : maybe<int>{2 * x}; }
+
+    maybe<bool> is_odd (int x)
+    { return maybe<bool>{x % 2 != 0}; }
+
+    constexpr std::size_t records = 1 << 16;
+
+    // Runs f on every record, and prints the allocations per record.
+    template <typename Inputs, typename Fn>
+    void run (char const * name, Inputs const & inputs, Fn f)
+    {
+        std::size_t const before = allocations;
+        for (auto const & input : inputs) {
+            bench::do_not_optimize(f(input));
+        }
+        double const per_record = double(allocations - before) / inputs.size();
+
+        bench::run(name, inputs.size(), 11, [&] {
+            for (auto const & input : inputs) {
+                bench::do_not_optimize(f(input));
+            }
+        });
+        std::printf("%-40s %10.2f allocations/record\n", "", per_record);
+    }
+
+}
+
+int main ()
+{
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<std::size_t> length(2, 8);
+    std::uniform_int_distribution<int> value(0, 1000);
+    std::vector<std::vector<int>> inputs(records);
+    std::vector<std::vector<maybe<int>>> maybe_inputs(records);
+    for (std::size_t i = 0; i < records; ++i) {
+        std::size_t const n = length(gen);
+        for (std::size_t j = 0; j < n; ++j) {
+            int const x = value(gen);
+            inputs[i].push_back(x);
+            maybe_inputs[i].push_back(maybe<int>{x});
+        }
+    }
+
+    run("map, std::vector", inputs, [](std::vector<int> const & r) {
+        return monad::map(checked_double, r);
+    });
+    run("map, small_list<8>", inputs, [](std::vector<int> const & r) {
+        return monad::map<monad::small_list<8>>(checked_double, r);
+    });
+
+    run("filter, std::vector", inputs, [](std::vector<int> const & r) {
+        return monad::filter(is_odd, r);
+    });
+    run("filter, small_list<8>", inputs, [](std::vector<int> const & r) {
+        return monad::filter<monad::small_list<8>>(is_odd, r);
+    });
+
+    using maybe_list = std::vector<maybe<int>>;
+    run("sequence, std::vector", maybe_inputs, [](maybe_list const & r) {
+        return monad::sequence(r);
+    });
+    run("sequence, small_list<8>", maybe_inputs, [](maybe_list const & r) {
+        return monad::sequence<monad::small_list<8>>(r);
+    });
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Compares map() and filter() over a single-pass input of 1M and 8M ints,
+// collected into a vector, to their streamed overloads passing chunks to
+// a summing sink, and reports the peak heap memory each uses.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/stream.cpp -o bench_stream
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "stream.hpp"
+#include "bench/harness.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    std::size_t live_bytes = 0;
+    std::size_t peak_bytes = 0;
+
+    // The size of each allocation is stored in front of it.
+    constexpr std::size_t header = alignof(std::max_align_t);
+
+}
+
+void * operator new (std::size_t size)
+{
+    if (char * p = static_cast<char *>(std::malloc(size + header))) {
+        *reinterpret_cast<std::size_t *>(p) = size;
+        live_bytes += size;
+        peak_bytes = std::max(peak_bytes, live_bytes);
+        return p + header;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete (void * p) noexcept
+{
+    if (!p)
+        return;
+    char * const base = static_cast<char *>(p) - header;
+    live_bytes -= *reinterpret_cast<std::size_t *>(base);
+    std::free(base);
+}
+
+void operator delete (void * p, std::size_t) noexcept
+{ operator delete(p); }
+
+namespace {
+
+    using monad::maybe;
+    using monad::span;
+
+    // A single-pass input of the integers [0, n), as from a generator.
+    struct counting_iterator
+    {
+        using iterator_category = std::input_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = int const *;
+        using reference = int const &;
+
+        int i;
+
+        int const & operator* () const
+        { return i; }
+        counting_iterator & operator++ ()
+        {
+            ++i;
+            return *this;
+        }
+        counting_iterator operator++ (int)
+        { return counting_iterator{i++}; }
+
+        friend bool operator== (counting_iterator lhs, counting_iterator rhs)
+        { return lhs.i == rhs.i; }
+        friend bool operator!= (counting_iterator lhs, counting_iterator rhs)
+        { return lhs.i != rhs.i; }
+    };
+
+    maybe<long> checked_square (int x)
+    { return x < 0 ? maybe<long>{monad::nothing} : maybe<long>{long(x) * x}; }
+
+    maybe<bool> is_odd (int x)
+    { return maybe<bool>{x % 2 != 0}; }
+
+    // Runs f, and prints its time and the peak heap memory it used.
+    template <typename Fn>
+    void run (std::string const & name, std::size_t elements, Fn f)
+    {
+        peak_bytes = live_bytes;
+        std::size_t const before = live_bytes;
+        bench::run(name.c_str(), elements, 5, f);
+        std::printf("%-40s %10.1f KB peak\n", "", (peak_bytes - before) / 1024.0);
+    }
+
+}
+
+int main ()
+{
+    for (int n : {1 << 20, 1 << 23}) {
+        std::string const suffix = ", " + std::to_string(n >> 20) + "M";
+        counting_iterator const first{0};
+        counting_iterator const last{n};
+
+        run("map, collected" + suffix, n, [&] {
+            auto const squares = monad::map(checked_square, first, last);
+            long sum = 0;
+            for (long x : squares.value()) {
+                sum += x;
+            }
+            bench::do_not_optimize(sum);
+        });
+        run("map, streamed" + suffix, n, [&] {
+            long sum = 0;
+            auto const state = monad::map(
+                monad::streamed,
+                checked_square,
+                first,
+                last,
+                [&sum](span<long> chunk) {
+                    for (long x : chunk) {
+                        sum += x;
+                    }
+                }
+            );
+            bench::do_not_optimize(state);
+            bench::do_not_optimize(sum);
+        });
+
+        run("filter, collected" + suffix, n, [&] {
+            auto const odds = monad::filter(is_odd, first, last);
+            bench::do_not_optimize(odds.value().size());
+        });
+        run("filter, streamed" + suffix, n, [&] {
+            std::size_t count = 0;
+            auto const state = monad::filter(
+                monad::streamed,
+                is_odd,
+                first,
+                last,
+                [&count](span<int> chunk) {count += chunk.size();}
+            );
+            bench::do_not_optimize(state);
+            bench::do_not_optimize(count);
+        });
+    }
+    return 0;
+}
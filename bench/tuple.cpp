@@ -0,0 +1,112 @@
+// Compares decoding a three-field record with traverse_as<record>() to the
+// same decoding written as a chain of nested binds.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/tuple.cpp -o bench_tuple
+
+#include "maybe/maybe.hpp"
+#include "algorithm.hpp"
+#include "bench/harness.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+
+namespace {
+
+    using monad::maybe;
+
+    struct record
+    {
+        int id;
+        std::string name;
+        int count;
+    };
+
+    maybe<int> decode_int (std::string_view s)
+    {
+        if (s.empty())
+            return monad::nothing;
+        int x = 0;
+        for (char c : s) {
+            if (c < '0' || '9' < c)
+                return monad::nothing;
+            x = 10 * x + (c - '0');
+        }
+        return maybe<int>{x};
+    }
+
+    maybe<std::string> decode_name (std::string_view s)
+    {
+        return s.empty() ?
+            maybe<std::string>{monad::nothing} :
+            maybe<std::string>{std::string(s)};
+    }
+
+    using fields = std::tuple<std::string_view, std::string_view, std::string_view>;
+
+    maybe<record> decode_traverse (fields const & f)
+    {
+        return monad::sequence_as<record>(std::make_tuple(
+            decode_int(std::get<0>(f)),
+            decode_name(std::get<1>(f)),
+            decode_int(std::get<2>(f))
+        ));
+    }
+
+    maybe<record> decode_binds (fields const & f)
+    {
+        return decode_int(std::get<0>(f)) >>= [&](int id) {
+            return decode_name(std::get<1>(f)) >>= [&](std::string const & name) {
+                return decode_int(std::get<2>(f)) >>= [&](int count) {
+                    return maybe<record>{record{id, name, count}};
+                };
+            };
+        };
+    }
+
+    constexpr std::size_t records = 1 << 18;
+
+}
+
+int main ()
+{
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 1 << 20);
+    std::vector<std::string> strings;
+    strings.reserve(3 * records);
+    for (std::size_t i = 0; i < records; ++i) {
+        strings.push_back(std::to_string(dist(gen)));
+        strings.push_back("a name too long for the SSO " + std::to_string(i));
+        strings.push_back(std::to_string(dist(gen) % 100));
+    }
+    std::vector<fields> inputs(records);
+    for (std::size_t i = 0; i < records; ++i) {
+        inputs[i] = fields{strings[3 * i], strings[3 * i + 1], strings[3 * i + 2]};
+    }
+
+    bench::run("nested binds", records, 11, [&] {
+        for (auto const & f : inputs) {
+            bench::do_not_optimize(decode_binds(f));
+        }
+    });
+    bench::run("sequence_as<record>", records, 11, [&] {
+        for (auto const & f : inputs) {
+            bench::do_not_optimize(decode_traverse(f));
+        }
+    });
+
+    for (auto const & f : inputs) {
+        auto const lhs = decode_binds(f);
+        auto const rhs = decode_traverse(f);
+        if (lhs.value().id != rhs.value().id || lhs.value().name != rhs.value().name) {
+            std::printf("MISMATCH\n");
+            break;
+        }
+    }
+
+    return 0;
+}
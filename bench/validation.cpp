@@ -0,0 +1,170 @@
+// Validates records of 50 text fields, each of which must be an integer
+// within a range, and collects every bad field of every record.  Compares
+// lift_n() over maybe, which stops at the first failure and so must be
+// followed by a field-by-field pass over each invalid record, to lift_n()
+// over validated, which reports every error in one pass; and map() over
+// the records with validated, sequentially and in parallel.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/validation.cpp -o bench_validation -pthread
+
+#include "maybe/maybe.hpp"
+#include "validation.hpp"
+#include "algorithm.hpp"
+#include "parallel.hpp"
+#include "bench/harness.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace {
+
+    using monad::maybe;
+    using monad::validated;
+
+    constexpr std::size_t fields = 50;
+    constexpr std::size_t records = 20000;
+
+    using record = std::array<std::string_view, fields>;
+
+    char const * const field_names[fields] = {
+        "f00", "f01", "f02", "f03", "f04", "f05", "f06", "f07", "f08", "f09",
+        "f10", "f11", "f12", "f13", "f14", "f15", "f16", "f17", "f18", "f19",
+        "f20", "f21", "f22", "f23", "f24", "f25", "f26", "f27", "f28", "f29",
+        "f30", "f31", "f32", "f33", "f34", "f35", "f36", "f37", "f38", "f39",
+        "f40", "f41", "f42", "f43", "f44", "f45", "f46", "f47", "f48", "f49"
+    };
+
+    // Parses s into x, and returns true if it is an integer in [0, 1000).
+    bool parse (std::string_view s, int & x)
+    {
+        auto const result = std::from_chars(s.data(), s.data() + s.size(), x);
+        return result.ec == std::errc() && result.ptr == s.data() + s.size() &&
+            0 <= x && x < 1000;
+    }
+
+    maybe<int> check_maybe (std::string_view s)
+    {
+        int x;
+        return parse(s, x) ? maybe<int>{x} : maybe<int>{monad::nothing};
+    }
+
+    validated<int> check_validated (
+        monad::error_arena & arena,
+        std::size_t field,
+        std::string_view s
+    ) {
+        int x;
+        return parse(s, x) ?
+            monad::valid(x) :
+            monad::invalid<int>(arena, field_names[field], "not in [0, 1000)");
+    }
+
+    auto const sum_fields = [](auto... xs) {return (0l + ... + xs);};
+
+    template <std::size_t ...Is>
+    maybe<long> validate_maybe (record const & r, std::index_sequence<Is...>)
+    { return monad::lift_n<maybe<long>>(sum_fields, check_maybe(r[Is])...); }
+
+    template <std::size_t ...Is>
+    validated<long> validate (
+        monad::error_arena & arena,
+        record const & r,
+        std::index_sequence<Is...>
+    ) {
+        return monad::lift_n<validated<long>>(
+            sum_fields,
+            check_validated(arena, Is, r[Is])...
+        );
+    }
+
+}
+
+int main ()
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> value(0, 999);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    // One record in ten has a bad field, and some have several.
+    std::vector<std::string> text(records * fields);
+    std::vector<record> inputs(records);
+    std::size_t expected_errors = 0;
+    for (std::size_t i = 0; i < records; ++i) {
+        std::string * const r = &text[i * fields];
+        for (std::size_t j = 0; j < fields; ++j) {
+            r[j] = std::to_string(value(gen));
+        }
+        if (percent(gen) < 10) {
+            int const bad = 1 + percent(gen) % 3;
+            for (int j = 0; j < bad; ++j) {
+                r[value(gen) % fields] = "-1";
+            }
+        }
+        for (std::size_t j = 0; j < fields; ++j) {
+            int x;
+            expected_errors += !parse(r[j], x);
+            inputs[i][j] = r[j];
+        }
+    }
+    auto const indices = std::make_index_sequence<fields>{};
+
+    std::size_t errors_found = 0;
+    bench::run("maybe, then field by field", records, 21, [&] {
+        std::vector<monad::validation_error> all_errors;
+        for (auto const & r : inputs) {
+            // Stops at the first bad field, so the fields of a bad record
+            // must be checked again one at a time to find the rest.
+            maybe<long> const m = validate_maybe(r, indices);
+            if (!m.state().nonempty_) {
+                for (std::size_t i = 0; i < fields; ++i) {
+                    if (!check_maybe(r[i]).state().nonempty_)
+                        all_errors.push_back({field_names[i], "not in [0, 1000)"});
+                }
+            }
+        }
+        errors_found = all_errors.size();
+        bench::do_not_optimize(all_errors.data());
+    });
+    std::printf("%-40s %10zu errors of %zu\n", "", errors_found, expected_errors);
+
+    monad::error_arena arena;
+    bench::run("validated", records, 21, [&] {
+        arena.clear();
+        std::vector<monad::validation_error> all_errors;
+        for (auto const & r : inputs) {
+            validated<long> const v = validate(arena, r, indices);
+            if (!monad::is_valid(v)) {
+                auto const errors = monad::errors(v);
+                all_errors.insert(all_errors.end(), errors.begin(), errors.end());
+            }
+        }
+        errors_found = all_errors.size();
+        bench::do_not_optimize(all_errors.data());
+    });
+    std::printf("%-40s %10zu errors of %zu\n", "", errors_found, expected_errors);
+
+    auto validate_one = [&](record const & r) {return validate(arena, r, indices);};
+    bench::run("map, validated", records, 21, [&] {
+        arena.clear();
+        auto const v = monad::map(validate_one, inputs);
+        errors_found = monad::error_count(v);
+        bench::do_not_optimize(v);
+    });
+    std::printf("%-40s %10zu errors of %zu\n", "", errors_found, expected_errors);
+
+    bench::run("map(par), validated", records, 21, [&] {
+        arena.clear();
+        auto const v = monad::map(monad::par, validate_one, inputs);
+        errors_found = monad::error_count(v);
+        bench::do_not_optimize(v);
+    });
+    std::printf("%-40s %10zu errors of %zu\n", "", errors_found, expected_errors);
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Measures std::vector<maybe<T>> growth by push_back() for a trivially
+// copyable payload and for std::string.  copy_only_maybe has maybe's old
+// special members (a user-declared copy constructor and copy assignment,
+// no moves), for comparison.
+// Build with e.g.:
+//     g++ -std=c++17 -O3 -I. bench/vector_growth.cpp -o bench_vector_growth
+
+#include "maybe/maybe.hpp"
+#include "bench/harness.hpp"
+
+#include <string>
+
+
+namespace {
+
+    template <typename T>
+    struct copy_only_maybe
+    {
+        copy_only_maybe (T t) :
+            value_ {t},
+            state_ {true}
+        {}
+
+        copy_only_maybe (const copy_only_maybe& rhs) = default;
+        copy_only_maybe& operator= (const copy_only_maybe& rhs) = default;
+
+        T value_;
+        monad::detail::maybe_state state_;
+    };
+
+    template <typename Maybe, typename T>
+    void grow (std::size_t size, T const & value)
+    {
+        std::vector<Maybe> v;
+        for (std::size_t i = 0; i < size; ++i) {
+            v.push_back(Maybe{value});
+        }
+        bench::do_not_optimize(v.data());
+    }
+
+}
+
+int main ()
+{
+    std::size_t const size = 10 * 1000 * 1000;
+    int const iterations = 5;
+
+    std::string const long_string(64, 'x');
+
+    bench::run("vector<maybe<int>>", size, iterations, [&] {
+        grow<monad::maybe<int>>(size, 42);
+    });
+
+    bench::run("vector<copy_only_maybe<int>>", size, iterations, [&] {
+        grow<copy_only_maybe<int>>(size, 42);
+    });
+
+    bench::run("vector<maybe<std::string>>", size, iterations, [&] {
+        grow<monad::maybe<std::string>>(size, long_string);
+    });
+
+    bench::run("vector<copy_only_maybe<std::string>>", size, iterations, [&] {
+        grow<copy_only_maybe<std::string>>(size, long_string);
+    });
+
+    return 0;
+}
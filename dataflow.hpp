@@ -0,0 +1,273 @@
+#ifndef DATAFLOW_HPP_INCLUDED_
+#define DATAFLOW_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+namespace monad {
+
+    class dataflow;
+
+    template <typename Monad>
+    class cell;
+
+    namespace detail {
+
+        struct dataflow_node
+        {
+            virtual ~dataflow_node () {}
+
+            // Recomputes the node's value from its arguments, and returns
+            // true if the value changed.
+            virtual bool recompute () = 0;
+
+            std::vector<std::size_t> dependents_;
+        };
+
+        template <typename Monad>
+        struct value_node : dataflow_node
+        {
+            explicit value_node (Monad value) :
+                value_ (std::move(value))
+            {}
+
+            Monad value_;
+        };
+
+        template <typename Monad>
+        struct input_node : value_node<Monad>
+        {
+            using value_node<Monad>::value_node;
+
+            bool recompute () override
+            { return false; }
+        };
+
+        template <typename ReturnMonad, typename Fn, typename ...Monads>
+        struct lift_node : value_node<ReturnMonad>
+        {
+            lift_node (Fn f, value_node<Monads> const * ...args) :
+                value_node<ReturnMonad> (
+                    lift_n<ReturnMonad>(f, args->value_...)
+                ),
+                f_ (f),
+                args_ (args...)
+            {}
+
+            bool recompute () override
+            {
+                ReturnMonad value = std::apply(
+                    [this](value_node<Monads> const * ...args) {
+                        return lift_n<ReturnMonad>(f_, args->value_...);
+                    },
+                    args_
+                );
+                if (value == this->value_)
+                    return false;
+                this->value_ = std::move(value);
+                return true;
+            }
+
+            Fn f_;
+            std::tuple<value_node<Monads> const *...> args_;
+        };
+
+    }
+
+    /** A graph of cells.  Input cells are created with input(), and
+        computed cells with lift_n() over other cells of the same graph.
+        Setting an input only marks its dependents; update() then
+        recomputes just the cells downstream of a change, in topological
+        order, so that each is recomputed at most once per update().  A
+        cell whose new value compares equal to its old one (e.g. nothing
+        to nothing, for maybe) does not cause its dependents to be
+        recomputed.  A dataflow must outlive its cells, and is not safe to
+        use from several threads at once. */
+    class dataflow
+    {
+    public:
+        dataflow () = default;
+        dataflow (dataflow const &) = delete;
+        dataflow & operator= (dataflow const &) = delete;
+
+        /** Creates an input cell with the value @c value. */
+        template <typename Monad>
+        cell<Monad> input (Monad value);
+
+        /** Recomputes the cells downstream of the inputs set since the last
+            call, and returns the number of cells recomputed.  If a lifted
+            function throws, the exception propagates, and the cells not yet
+            recomputed are recomputed by the next call. */
+        std::size_t update ()
+        {
+            std::size_t retval = 0;
+            for (; first_queued_level_ < queued_.size(); ++first_queued_level_) {
+                std::vector<std::size_t> & queued = queued_[first_queued_level_];
+                while (!queued.empty()) {
+                    // i is dequeued only once it has been recomputed, so
+                    // that if its function throws, the next call
+                    // recomputes it and then its dependents.  Its
+                    // dependents are at higher levels, so i is still at
+                    // the back of queued.
+                    std::size_t const i = queued.back();
+                    bool const changed = nodes_[i]->recompute();
+                    queued.pop_back();
+                    queued_flags_[i] = false;
+                    ++retval;
+                    if (changed)
+                        enqueue_dependents(i);
+                }
+            }
+            return retval;
+        }
+
+        /** The number of cells in the graph. */
+        std::size_t size () const
+        { return nodes_.size(); }
+
+    private:
+        // Each node's level is one more than the highest level among its
+        // arguments, so a node's arguments are always recomputed before
+        // it if the queued nodes are recomputed level by level.  Nodes at
+        // the same level do not depend on each other.
+        void enqueue_dependents (std::size_t i)
+        {
+            for (std::size_t dependent : nodes_[i]->dependents_) {
+                if (queued_flags_[dependent])
+                    continue;
+                queued_flags_[dependent] = true;
+                std::size_t const level = levels_[dependent];
+                queued_[level].push_back(dependent);
+                if (level < first_queued_level_)
+                    first_queued_level_ = level;
+            }
+        }
+
+        std::size_t add (
+            std::unique_ptr<detail::dataflow_node> node,
+            std::size_t level
+        ) {
+            nodes_.push_back(std::move(node));
+            levels_.push_back(level);
+            queued_flags_.push_back(false);
+            if (queued_.size() <= level)
+                queued_.resize(level + 1);
+            return nodes_.size() - 1;
+        }
+
+        std::vector<std::unique_ptr<detail::dataflow_node>> nodes_;
+        std::vector<std::size_t> levels_;
+        std::vector<bool> queued_flags_;
+        std::vector<std::vector<std::size_t>> queued_;
+        std::size_t first_queued_level_ = 0;
+
+        template <typename Monad>
+        friend class cell;
+
+        template <typename ReturnMonad, typename Fn, typename M, typename ...Ms>
+        friend cell<ReturnMonad> lift_n (Fn f, cell<M> c, cell<Ms>... cells);
+    };
+
+    /** A handle to a value in a dataflow.  Copies refer to the same
+        value. */
+    template <typename Monad>
+    class cell
+    {
+    public:
+        using monad_type = Monad;
+
+        Monad const & value () const
+        { return node_->value_; }
+
+        /** Sets the value of an input cell.  The cells that depend on it
+            are recomputed by the next dataflow::update().  Setting a value
+            equal to the current one does nothing.  Throws std::logic_error
+            if this is not an input cell. */
+        void set (Monad value)
+        {
+            if (!dynamic_cast<detail::input_node<Monad> *>(node_))
+                throw std::logic_error("Only input cells may be set.");
+            if (value == node_->value_)
+                return;
+            node_->value_ = std::move(value);
+            graph_->enqueue_dependents(index_);
+        }
+
+        dataflow & graph () const
+        { return *graph_; }
+
+    private:
+        cell (dataflow * graph, std::size_t index, detail::value_node<Monad> * node) :
+            graph_ (graph),
+            index_ (index),
+            node_ (node)
+        {}
+
+        dataflow * graph_;
+        std::size_t index_;
+        detail::value_node<Monad> * node_;
+
+        friend class dataflow;
+
+        template <typename M>
+        friend class cell;
+
+        template <typename ReturnMonad, typename Fn, typename M, typename ...Ms>
+        friend cell<ReturnMonad> lift_n (Fn f, cell<M> c, cell<Ms>... cells);
+    };
+
+    template <typename Monad>
+    cell<Monad> dataflow::input (Monad value)
+    {
+        auto node = std::make_unique<detail::input_node<Monad>>(std::move(value));
+        detail::input_node<Monad> * const ptr = node.get();
+        std::size_t const index = add(std::move(node), 0);
+        return cell<Monad>{this, index, ptr};
+    }
+
+    /** lift_n() for cells.  Returns a cell of the same dataflow whose value
+        is always <c>lift_n<ReturnMonad>(f, c.value(), cells.value()...)</c>,
+        recomputed by dataflow::update() when any of its arguments change.
+        Throws std::invalid_argument if the cells belong to different
+        dataflows. */
+    template <typename ReturnMonad, typename Fn, typename M, typename ...Ms>
+    cell<ReturnMonad> lift_n (Fn f, cell<M> c, cell<Ms>... cells)
+    {
+        dataflow * const graph = c.graph_;
+        bool const same_graph[] = {true, (cells.graph_ == graph)...};
+        for (bool same : same_graph) {
+            if (!same)
+                throw std::invalid_argument("Cells must belong to the same dataflow.");
+        }
+
+        std::size_t const arg_indices[] = {c.index_, cells.index_...};
+        std::size_t level = 0;
+        for (std::size_t i : arg_indices) {
+            level = std::max(level, graph->levels_[i] + 1);
+        }
+
+        using node_type = detail::lift_node<ReturnMonad, Fn, M, Ms...>;
+        auto node = std::make_unique<node_type>(f, c.node_, cells.node_...);
+        node_type * const ptr = node.get();
+        std::size_t const index = graph->add(std::move(node), level);
+
+        for (std::size_t i : arg_indices) {
+            std::vector<std::size_t> & dependents = graph->nodes_[i]->dependents_;
+            if (std::find(dependents.begin(), dependents.end(), index) == dependents.end())
+                dependents.push_back(index);
+        }
+
+        return cell<ReturnMonad>{graph, index, ptr};
+    }
+
+}
+
+#endif
@@ -1,61 +1,478 @@
 #ifndef DECLARE_OPERATORS_HPP_INCLUDED_
 #define DECLARE_OPERATORS_HPP_INCLUDED_
 
+#include <maybe/maybe.hpp>
 
-#define MONAD_BINARY_OP(op, monad_type)                             \
-    monad_type operator op (monad_type lhs, monad_type rhs)         \
-    {                                                               \
-        using value_type = monad_type::value_type;                  \
-        return lhs >>= [rhs](value_type x) {                        \
-            return rhs >>= [x](value_type y) {                      \
-                return monad_type{x + y};                           \
-            };                                                      \
-        };                                                          \
-    }
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace monad {
+
+    /** Specialize this to derive from std::true_type to give the monads
+        with state @c State the lifted operators declared below.  It is
+        specialized for maybe.
+
+        The lifted operators are the arithmetic, bitwise and relational
+        operators, and their compound assignment forms.  @c << and @c >>
+        (and their assignment forms) are not lifted, since @c >>, @c >>=
+        and @c <<= are the monadic operators; nor are @c == and @c !=,
+        which compare monads rather than producing a monad.  The result of
+        e.g. <c>lhs + rhs</c> has a value of type <c>decltype(x + y)</c>,
+        where @c x and @c y are the values of @c lhs and @c rhs; for
+        short-circuiting states, it has the state of the first failed
+        operand, or that of @c rhs if neither failed.  The payload of an
+        rvalue operand is moved into the operation, so that e.g.
+        <c>std::move(a) + b</c> may reuse the storage of @c a's value. */
+    template <typename State>
+    struct lifted_operators : std::false_type
+    {};
+
+    template <>
+    struct lifted_operators<detail::maybe_state> : std::true_type
+    {};
+
+    namespace detail {
+
+        template <typename T>
+        struct is_monad : std::false_type
+        {};
+
+        template <typename T, typename State>
+        struct is_monad<monad<T, State>> : std::true_type
+        {};
+
+        template <typename M>
+        using operand_t =
+            typename std::remove_cv<typename std::remove_reference<M>::type>::type;
+
+        template <typename M, typename = void>
+        struct lifted_operand : std::false_type
+        {};
+
+        template <typename M>
+        struct lifted_operand<
+            M,
+            typename std::enable_if<is_monad<operand_t<M>>::value>::type
+        > : lifted_operators<typename operand_t<M>::state_type>
+        {};
+
+        template <typename L, typename R>
+        constexpr bool lifted_binary_operands ()
+        {
+            if constexpr (lifted_operand<L>::value && lifted_operand<R>::value) {
+                return std::is_same<
+                    typename operand_t<L>::state_type,
+                    typename operand_t<R>::state_type
+                >::value;
+            } else {
+                return false;
+            }
+        }
+
+        // For SFINAE.
+        template <typename L, typename R>
+        using enable_lifted_binary_t =
+            typename std::enable_if<lifted_binary_operands<L, R>()>::type;
+
+        template <typename M>
+        using enable_lifted_unary_t =
+            typename std::enable_if<lifted_operand<M>::value>::type;
+
+        // The value of m; moved out of m if M is not an lvalue reference.
+        template <typename M>
+        constexpr decltype(auto) operand_value (M && m)
+        {
+            using value_type = typename operand_t<M>::value_type;
+            if constexpr (
+                std::is_lvalue_reference<M>::value ||
+                std::is_reference<value_type>::value
+            ) {
+                return static_cast<operand_t<M> const &>(m).value();
+            } else {
+                return std::move(m.mutable_value());
+            }
+        }
+
+        // Constructs monad<R, State> from the state and the value that
+        // make() returns.  The value is constructed in place where the
+        // monad supports it.
+        template <typename Result, typename State, typename Make>
+        constexpr Result make_lifted (State const & state, Make make)
+        {
+            using value_type = typename Result::value_type;
+            if constexpr (
+                std::is_constructible<
+                    Result,
+                    std::in_place_t,
+                    State,
+                    value_type
+                >::value
+            ) {
+                return Result{std::in_place, state, make()};
+            } else {
+                return Result{make(), state};
+            }
+        }
+
+        template <typename Op, typename L, typename R>
+        using lifted_value_t = typename std::remove_cv<
+            typename std::remove_reference<
+                decltype(std::declval<Op>()(
+                    operand_value(std::declval<L>()),
+                    operand_value(std::declval<R>())
+                ))
+            >::type
+        >::type;
+
+        template <typename Op, typename L, typename R>
+        constexpr auto lifted_binary (Op op, L && lhs, R && rhs) ->
+            monad<lifted_value_t<Op, L, R>, typename operand_t<L>::state_type>
+        {
+            using state_type = typename operand_t<L>::state_type;
+            using value_type = lifted_value_t<Op, L, R>;
+            using result_type = monad<value_type, state_type>;
+
+            if constexpr (monad_traits<state_type>::short_circuits) {
+                if (monad_traits<state_type>::failed(lhs.state()))
+                    return result_type{value_type{}, lhs.state()};
+                if (monad_traits<state_type>::failed(rhs.state()))
+                    return result_type{value_type{}, rhs.state()};
+                return make_lifted<result_type>(rhs.state(), [&]() -> decltype(auto) {
+                    return op(
+                        operand_value(std::forward<L>(lhs)),
+                        operand_value(std::forward<R>(rhs))
+                    );
+                });
+            } else {
+                return lhs >>= [&rhs, op](auto const & x) {
+                    return rhs >>= [&x, op](auto const & y) {
+                        return result_type{op(x, y)};
+                    };
+                };
+            }
+        }
+
+        template <typename Op, typename M>
+        constexpr auto lifted_unary (Op op, M && m) ->
+            monad<
+                typename std::remove_cv<
+                    typename std::remove_reference<
+                        decltype(op(operand_value(std::forward<M>(m))))
+                    >::type
+                >::type,
+                typename operand_t<M>::state_type
+            >
+        {
+            using state_type = typename operand_t<M>::state_type;
+            using value_type = typename std::remove_cv<
+                typename std::remove_reference<
+                    decltype(op(operand_value(std::forward<M>(m))))
+                >::type
+            >::type;
+            using result_type = monad<value_type, state_type>;
+
+            if constexpr (monad_traits<state_type>::short_circuits) {
+                if (monad_traits<state_type>::failed(m.state()))
+                    return result_type{value_type{}, m.state()};
+                return make_lifted<result_type>(m.state(), [&]() -> decltype(auto) {
+                    return op(operand_value(std::forward<M>(m)));
+                });
+            } else {
+                return m >>= [op](auto const & x) {
+                    return result_type{op(x)};
+                };
+            }
+        }
+
+        // The compound assignment applies op to lhs's value in place.  If
+        // either operand has failed, lhs takes the state of the first
+        // failure, and its value is unchanged.
+        template <typename Op, typename M, typename R>
+        constexpr M & lifted_assign (Op op, M & lhs, R && rhs)
+        {
+            using state_type = typename M::state_type;
+
+            if constexpr (monad_traits<state_type>::short_circuits) {
+                if (monad_traits<state_type>::failed(lhs.state()))
+                    return lhs;
+                if (!monad_traits<state_type>::failed(rhs.state()))
+                    op(lhs.mutable_value(), operand_value(std::forward<R>(rhs)));
+                lhs.mutable_state() = rhs.state();
+            } else {
+                lhs = lhs >>= [&rhs, op](auto const & x) {
+                    return rhs >>= [&x, op](auto const & y) {
+                        typename M::value_type value = x;
+                        op(value, y);
+                        return M{std::move(value)};
+                    };
+                };
+            }
+            return lhs;
+        }
+
+        struct unary_plus
+        {
+            template <typename T>
+            constexpr auto operator() (T && x) const -> decltype(+std::forward<T>(x))
+            { return +std::forward<T>(x); }
+        };
+
+#define MONAD_ASSIGN_OP_FUNCTOR(name, op)                                   \
+        struct name                                                         \
+        {                                                                   \
+            template <typename T, typename U>                               \
+            constexpr void operator() (T & lhs, U && rhs) const             \
+            { lhs op std::forward<U>(rhs); }                                \
+        };
+
+        MONAD_ASSIGN_OP_FUNCTOR(plus_assign, +=)
+        MONAD_ASSIGN_OP_FUNCTOR(minus_assign, -=)
+        MONAD_ASSIGN_OP_FUNCTOR(multiplies_assign, *=)
+        MONAD_ASSIGN_OP_FUNCTOR(divides_assign, /=)
+        MONAD_ASSIGN_OP_FUNCTOR(modulus_assign, %=)
+        MONAD_ASSIGN_OP_FUNCTOR(bit_and_assign, &=)
+        MONAD_ASSIGN_OP_FUNCTOR(bit_or_assign, |=)
+        MONAD_ASSIGN_OP_FUNCTOR(bit_xor_assign, ^=)
+
+#undef MONAD_ASSIGN_OP_FUNCTOR
+
+        // True if Op cannot trap on any pair of operands, so that it may be
+        // applied to the payloads of failed elements.
+        template <typename Op>
+        struct nontrapping_op : std::false_type
+        {};
+
+        template <>
+        struct nontrapping_op<std::plus<>> : std::true_type
+        {};
+        template <>
+        struct nontrapping_op<std::minus<>> : std::true_type
+        {};
+        template <>
+        struct nontrapping_op<std::multiplies<>> : std::true_type
+        {};
+        template <>
+        struct nontrapping_op<std::bit_and<>> : std::true_type
+        {};
+        template <>
+        struct nontrapping_op<std::bit_or<>> : std::true_type
+        {};
+        template <>
+        struct nontrapping_op<std::bit_xor<>> : std::true_type
+        {};
+
+        // The type in which the element-wise loop computes op on values of
+        // type T.  Signed integers are computed as unsigned, so that the
+        // unconditional computation on the payloads of failed elements
+        // cannot overflow.
+        template <typename T, bool = std::is_integral<T>::value>
+        struct elementwise_calc
+        {
+            using type = T;
+        };
+
+        template <typename T>
+        struct elementwise_calc<T, true>
+        {
+            using type = typename std::make_unsigned<T>::type;
+        };
+
+        // The loops of lifted_elementwise().  The pointers are __restrict
+        // (which GCC, Clang and MSVC all accept), since the compiler cannot
+        // otherwise tell that out does not alias l or r.
+        template <typename Op, typename T, typename U, typename Result>
+        void elementwise_kernel (
+            Op op,
+            T const * __restrict l,
+            U const * __restrict r,
+            Result * __restrict out,
+            std::size_t size
+        ) {
+            using state_type = typename Result::state_type;
+            using value_type = typename Result::value_type;
+            using l_value_type = typename T::value_type;
+            using r_value_type = typename U::value_type;
+
+            if constexpr (
+                std::is_same<state_type, maybe_state>::value &&
+                nontrapping_op<Op>::value &&
+                std::is_same<l_value_type, value_type>::value &&
+                std::is_same<r_value_type, value_type>::value &&
+                (!std::is_integral<value_type>::value ||
+                 sizeof(int) <= sizeof(value_type))
+            ) {
+                // Vectorizes: the values are computed unconditionally, and
+                // do not depend on the flags, and the flags are read in
+                // place through state_ref() rather than copied out by
+                // state().  GCC vectorizes neither a select on the flags
+                // nor a copy of a state.
+                using calc_type = typename elementwise_calc<value_type>::type;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+                for (std::size_t i = 0; i < size; ++i) {
+                    bool const ok =
+                        l[i].state_ref().nonempty_ & r[i].state_ref().nonempty_;
+                    out[i].mutable_value() = static_cast<value_type>(op(
+                        static_cast<calc_type>(l[i].value()),
+                        static_cast<calc_type>(r[i].value())
+                    ));
+                    out[i].mutable_state().nonempty_ = ok;
+                }
+            } else {
+                // The operands of failed elements are replaced with 0 and 1,
+                // which are safe for every lifted operator, including / and
+                // %.
+                for (std::size_t i = 0; i < size; ++i) {
+                    state_type const l_state = l[i].state();
+                    state_type const state =
+                        monad_traits<state_type>::failed(l_state) ?
+                        l_state : r[i].state();
+                    bool const ok = !monad_traits<state_type>::failed(state);
+                    l_value_type const x = ok ? l[i].value() : l_value_type(0);
+                    r_value_type const y = ok ? r[i].value() : r_value_type(1);
+                    out[i].mutable_value() = static_cast<value_type>(op(x, y));
+                    out[i].mutable_state() = state;
+                }
+            }
+        }
+
+        // Element-wise application of op over two vectors of monads.  For
+        // arithmetic values with a short-circuiting state, the loop has no
+        // branches, and for +, -, *, &, | and ^ on maybe it vectorizes.
+        template <typename Op, typename T, typename U, typename State>
+        auto lifted_elementwise (
+            Op op,
+            std::vector<monad<T, State>> const & lhs,
+            std::vector<monad<U, State>> const & rhs
+        ) -> std::vector<decltype(lifted_binary(op, lhs[0], rhs[0]))>
+        {
+            using result_type = decltype(lifted_binary(op, lhs[0], rhs[0]));
+            using value_type = typename result_type::value_type;
+
+            if (lhs.size() != rhs.size()) {
+                throw std::invalid_argument(
+                    "Element-wise operands must have the same size."
+                );
+            }
+
+            std::size_t const size = lhs.size();
+            std::vector<result_type> retval;
+
+            if constexpr (
+                monad_traits<State>::short_circuits &&
+                std::is_arithmetic<T>::value &&
+                std::is_arithmetic<U>::value &&
+                std::is_arithmetic<value_type>::value
+            ) {
+                retval.resize(size);
+                elementwise_kernel(op, lhs.data(), rhs.data(), retval.data(), size);
+            } else {
+                retval.reserve(size);
+                for (std::size_t i = 0; i < size; ++i) {
+                    retval.push_back(lifted_binary(op, lhs[i], rhs[i]));
+                }
+            }
+
+            return retval;
+        }
 
-#define MONAD_NAMED_BINARY_OP(name, op, monad_type)                 \
-    monad_type name (monad_type lhs, monad_type rhs)                \
-    {                                                               \
-        using value_type = monad_type::value_type;                  \
-        return lhs >>= [ rhs](value_type x) {                       \
-            return rhs >>= [x](value_type y) {                      \
-                return monad_type{x + y};                           \
-            };                                                      \
-        };                                                          \
     }
 
-#define MONAD_TEMPLATE_BINARY_OP(op, monad_name, num_template_args) \
-    template <BOOST_PP_ENUM_PARAMS(num_template_args, typename T)>  \
-    monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)>          \
-    operator op (                                                   \
-        monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)> lhs, \
-        monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)> rhs  \
-    ) {                                                             \
-        using monad_type =                                          \
-            monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)>; \
-        using value_type = typename monad_type::value_type;         \
-        return lhs >>= [rhs](value_type x) {                        \
-            return rhs >>= [x](value_type y) {                      \
-                return monad_type{x + y};                           \
-            };                                                      \
-        };                                                          \
+#define MONAD_LIFTED_BINARY_OP(op, functor)                                 \
+    template <                                                              \
+        typename L,                                                         \
+        typename R,                                                         \
+        typename = detail::enable_lifted_binary_t<L, R>                     \
+    >                                                                       \
+    constexpr auto operator op (L && lhs, R && rhs) ->                      \
+        decltype(detail::lifted_binary(                                     \
+            functor{}, std::forward<L>(lhs), std::forward<R>(rhs)))         \
+    {                                                                       \
+        return detail::lifted_binary(                                       \
+            functor{}, std::forward<L>(lhs), std::forward<R>(rhs));         \
     }
 
-#define MONAD_TEMPLATE_NAMED_BINARY_OP(name, op, monad_name, num_template_args)\
-    template <BOOST_PP_ENUM_PARAMS(num_template_args, typename T)>      \
-    monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)>              \
-    name (                                                              \
-        monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)> lhs,     \
-        monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)> rhs      \
-    ) {                                                                 \
-        using monad_type =                                              \
-            monad_name<BOOST_PP_ENUM_PARAMS(num_template_args, T)>;     \
-        using value_type = typename monad_type::value_type;             \
-        return lhs >>= [rhs](value_type x) {                            \
-            return rhs >>= [x](value_type y) {                          \
-                return monad_type{x + y};                               \
-            };                                                          \
-        };                                                              \
+// The relational operators are not applied element-wise, since
+// std::vector's own would be ambiguous with them.
+#define MONAD_LIFTED_ELEMENTWISE_OP(op, functor)                            \
+    template <                                                              \
+        typename T,                                                         \
+        typename U,                                                         \
+        typename State,                                                     \
+        typename = typename std::enable_if<                                 \
+            lifted_operators<State>::value                                  \
+        >::type                                                             \
+    >                                                                       \
+    auto operator op (                                                      \
+        std::vector<monad<T, State>> const & lhs,                           \
+        std::vector<monad<U, State>> const & rhs                            \
+    ) -> decltype(detail::lifted_elementwise(functor{}, lhs, rhs))          \
+    { return detail::lifted_elementwise(functor{}, lhs, rhs); }
+
+#define MONAD_LIFTED_ASSIGN_OP(op, functor)                                 \
+    template <                                                              \
+        typename T,                                                         \
+        typename State,                                                     \
+        typename R,                                                         \
+        typename = detail::enable_lifted_binary_t<monad<T, State> &, R>     \
+    >                                                                       \
+    constexpr monad<T, State> & operator op (monad<T, State> & lhs, R && rhs) \
+    {                                                                       \
+        return detail::lifted_assign(                                       \
+            functor{}, lhs, std::forward<R>(rhs));                          \
     }
 
+#define MONAD_LIFTED_UNARY_OP(op, functor)                                  \
+    template <typename M, typename = detail::enable_lifted_unary_t<M>>      \
+    constexpr auto operator op (M && m) ->                                  \
+        decltype(detail::lifted_unary(functor{}, std::forward<M>(m)))       \
+    { return detail::lifted_unary(functor{}, std::forward<M>(m)); }
+
+    MONAD_LIFTED_BINARY_OP(+, std::plus<>)
+    MONAD_LIFTED_BINARY_OP(-, std::minus<>)
+    MONAD_LIFTED_BINARY_OP(*, std::multiplies<>)
+    MONAD_LIFTED_BINARY_OP(/, std::divides<>)
+    MONAD_LIFTED_BINARY_OP(%, std::modulus<>)
+    MONAD_LIFTED_BINARY_OP(&, std::bit_and<>)
+    MONAD_LIFTED_BINARY_OP(|, std::bit_or<>)
+    MONAD_LIFTED_BINARY_OP(^, std::bit_xor<>)
+    MONAD_LIFTED_BINARY_OP(<, std::less<>)
+    MONAD_LIFTED_BINARY_OP(>, std::greater<>)
+    MONAD_LIFTED_BINARY_OP(<=, std::less_equal<>)
+    MONAD_LIFTED_BINARY_OP(>=, std::greater_equal<>)
+
+    MONAD_LIFTED_ELEMENTWISE_OP(+, std::plus<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(-, std::minus<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(*, std::multiplies<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(/, std::divides<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(%, std::modulus<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(&, std::bit_and<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(|, std::bit_or<>)
+    MONAD_LIFTED_ELEMENTWISE_OP(^, std::bit_xor<>)
+
+    MONAD_LIFTED_ASSIGN_OP(+=, detail::plus_assign)
+    MONAD_LIFTED_ASSIGN_OP(-=, detail::minus_assign)
+    MONAD_LIFTED_ASSIGN_OP(*=, detail::multiplies_assign)
+    MONAD_LIFTED_ASSIGN_OP(/=, detail::divides_assign)
+    MONAD_LIFTED_ASSIGN_OP(%=, detail::modulus_assign)
+    MONAD_LIFTED_ASSIGN_OP(&=, detail::bit_and_assign)
+    MONAD_LIFTED_ASSIGN_OP(|=, detail::bit_or_assign)
+    MONAD_LIFTED_ASSIGN_OP(^=, detail::bit_xor_assign)
+
+    MONAD_LIFTED_UNARY_OP(+, detail::unary_plus)
+    MONAD_LIFTED_UNARY_OP(-, std::negate<>)
+    MONAD_LIFTED_UNARY_OP(~, std::bit_not<>)
+
+#undef MONAD_LIFTED_BINARY_OP
+#undef MONAD_LIFTED_ELEMENTWISE_OP
+#undef MONAD_LIFTED_ASSIGN_OP
+#undef MONAD_LIFTED_UNARY_OP
+
+}
+
 #endif
@@ -0,0 +1,568 @@
+#ifndef DETAIL_ALGORITHM_HPP_INCLUDED_
+#define DETAIL_ALGORITHM_HPP_INCLUDED_
+
+#include <detail/detail.hpp>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+
+namespace monad { namespace detail {
+
+    template <typename Container, typename Iter, typename Tag>
+    void reserve_impl (Container&, Iter, Iter, Tag)
+    {}
+
+    template <typename Container, typename Iter>
+    auto reserve_impl (Container& c,
+                       Iter first,
+                       Iter last,
+                       std::random_access_iterator_tag) ->
+        decltype(c.reserve(last - first)) // For SFINAE.
+    { c.reserve(last - first); }
+
+    template <typename Container>
+    void reserve_n_impl (Container&, std::size_t, ...)
+    {}
+
+    template <typename Container>
+    auto reserve_n_impl (Container& c, std::size_t n, int) ->
+        decltype(c.reserve(n)) // For SFINAE.
+    { c.reserve(n); }
+
+    template <typename Container>
+    void reserve_n (Container& c, std::size_t n)
+    { reserve_n_impl(c, n, 0); }
+
+    template <typename Container, typename Iter>
+    void reserve (Container& c, Iter first, Iter last)
+    {
+        reserve_impl(
+            c,
+            first,
+            last,
+            typename std::iterator_traits<Iter>::iterator_category{}
+        );
+    }
+
+    // For short-circuiting states, f is not called on the elements after
+    // the first failure.  For states whose traits set
+    // state_independent_of_values, the result's state is computed with
+    // combine() instead of a chain of >>=.
+    template <
+        typename Iter,
+        typename Monad,
+        typename List,
+        typename State,
+        typename Fn
+    >
+    monad<List, State> sequence_impl (Fn f, Iter first, Iter last)
+    {
+        using traits = monad_traits<State>;
+
+        if (first == last)
+            return monad<List, State>{};
+
+        monad<List, State> retval{List{}};
+
+        detail::reserve(retval.mutable_value(), first, last);
+
+        Monad prev = f(first);
+        ++first;
+
+        // For short-circuiting states, the result's state is final once it
+        // indicates failure, and a failed monad's value (e.g. that of a
+        // maybe<T &>) may not be accessible, so the loop stops there.
+        if (traits::failed(prev.state())) {
+            retval.mutable_state() = prev.state();
+            return retval;
+        }
+
+        if constexpr (traits::state_independent_of_values) {
+            State state = prev.state();
+            retval.mutable_value().push_back(std::move(prev).value());
+            while (first != last) {
+                Monad m = f(first);
+                ++first;
+                state = traits::combine(state, m.state());
+                if (traits::failed(state))
+                    break;
+                retval.mutable_value().push_back(std::move(m).value());
+            }
+            retval.mutable_state() = state;
+        } else {
+            retval.mutable_value().push_back(prev.value());
+            while (first != last) {
+                Monad m = f(first);
+                ++first;
+                prev = prev >>= [=](typename Monad::value_type const &) {
+                    return m;
+                };
+                if (traits::failed(prev.state()))
+                    break;
+                retval.mutable_value().push_back(m.value());
+            }
+            retval.mutable_state() = prev.state();
+        }
+
+        return retval;
+    }
+
+    // Like sequence_impl(), but only the state of the result is computed.
+    // For short-circuiting states, f is not called on the elements after
+    // the first failure.
+    template <
+        typename Iter,
+        typename Monad,
+        typename State,
+        typename Fn
+    >
+    monad<unit, State> sequence_discard_impl (Fn f, Iter first, Iter last)
+    {
+        using traits = monad_traits<State>;
+
+        if (first == last)
+            return monad<unit, State>{};
+
+        Monad prev = f(first);
+        ++first;
+
+        if constexpr (traits::state_independent_of_values) {
+            State state = prev.state();
+            while (first != last && !traits::failed(state)) {
+                state = traits::combine(state, f(first).state());
+                ++first;
+            }
+            return monad<unit, State>{unit{}, state};
+        } else if constexpr (traits::short_circuits) {
+            while (first != last && !traits::failed(prev.state())) {
+                prev = f(first);
+                ++first;
+            }
+        } else {
+            while (first != last) {
+                Monad m = f(first);
+                ++first;
+                prev = prev >>= [=](typename Monad::value_type const &) {
+                    return m;
+                };
+            }
+        }
+
+        return monad<unit, State>{unit{}, prev.state()};
+    }
+
+    // Like sequence_impl(), but for a result whose size N is known at
+    // compile time.  f(i) must return the monad for the i-th element.
+    template <
+        typename Monad,
+        typename Array,
+        typename State,
+        typename Fn
+    >
+    constexpr monad<Array, State> array_sequence_impl (Fn f)
+    {
+        using traits = monad_traits<State>;
+        constexpr std::size_t N = std::tuple_size<Array>::value;
+
+        if (N == 0)
+            return monad<Array, State>{};
+
+        monad<Array, State> retval{Array{}};
+
+        Monad prev = f(0);
+        retval.mutable_value()[0] = prev.value();
+
+        if constexpr (traits::state_independent_of_values) {
+            State state = prev.state();
+            for (std::size_t i = 1; i < N; ++i) {
+                Monad m = f(i);
+                retval.mutable_value()[i] = m.value();
+                state = traits::combine(state, m.state());
+            }
+            retval.mutable_state() = state;
+        } else {
+            for (std::size_t i = 1; i < N; ++i) {
+                Monad m = f(i);
+                retval.mutable_value()[i] = m.value();
+                prev = prev >>= [=](typename Monad::value_type const &) {
+                    return m;
+                };
+            }
+            retval.mutable_state() = prev.state();
+        }
+
+        return retval;
+    }
+
+    // True if Iter is known to refer to elements stored contiguously, so
+    // that [first, last) may be read through &*first.
+    template <typename Iter>
+    struct is_contiguous_iterator :
+#if defined(__cpp_lib_concepts)
+        std::integral_constant<bool, std::contiguous_iterator<Iter>>
+#else
+        std::integral_constant<
+            bool,
+            std::is_pointer<Iter>::value ||
+            std::is_same<
+                Iter,
+                typename std::vector<
+                    typename std::iterator_traits<Iter>::value_type
+                >::iterator
+            >::value ||
+            std::is_same<
+                Iter,
+                typename std::vector<
+                    typename std::iterator_traits<Iter>::value_type
+                >::const_iterator
+            >::value
+        >
+#endif
+    {};
+
+    template <typename State, typename = void>
+    struct has_present_flag : std::false_type
+    {};
+
+    template <typename State>
+    struct has_present_flag<
+        State,
+        decltype(void(present_flag(std::declval<State const &>())))
+    > : std::true_type
+    {};
+
+    // A random access iterator over the values of a contiguous sequence of
+    // monads, used to append them to a list in bulk.
+    template <typename Monad>
+    struct value_iterator
+    {
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename Monad::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type const *;
+        using reference = value_type const &;
+
+        Monad const * it;
+
+        reference operator* () const
+        { return it->value(); }
+        reference operator[] (difference_type n) const
+        { return it[n].value(); }
+
+        value_iterator & operator++ ()
+        {
+            ++it;
+            return *this;
+        }
+        value_iterator operator++ (int)
+        { return value_iterator{it++}; }
+        value_iterator & operator-- ()
+        {
+            --it;
+            return *this;
+        }
+        value_iterator operator-- (int)
+        { return value_iterator{it--}; }
+        value_iterator & operator+= (difference_type n)
+        {
+            it += n;
+            return *this;
+        }
+        value_iterator & operator-= (difference_type n)
+        {
+            it -= n;
+            return *this;
+        }
+
+        friend value_iterator operator+ (value_iterator lhs, difference_type n)
+        { return value_iterator{lhs.it + n}; }
+        friend value_iterator operator+ (difference_type n, value_iterator rhs)
+        { return value_iterator{rhs.it + n}; }
+        friend value_iterator operator- (value_iterator lhs, difference_type n)
+        { return value_iterator{lhs.it - n}; }
+        friend difference_type operator- (value_iterator lhs, value_iterator rhs)
+        { return lhs.it - rhs.it; }
+        friend bool operator== (value_iterator lhs, value_iterator rhs)
+        { return lhs.it == rhs.it; }
+        friend bool operator!= (value_iterator lhs, value_iterator rhs)
+        { return lhs.it != rhs.it; }
+        friend bool operator< (value_iterator lhs, value_iterator rhs)
+        { return lhs.it < rhs.it; }
+        friend bool operator<= (value_iterator lhs, value_iterator rhs)
+        { return lhs.it <= rhs.it; }
+        friend bool operator> (value_iterator lhs, value_iterator rhs)
+        { return lhs.it > rhs.it; }
+        friend bool operator>= (value_iterator lhs, value_iterator rhs)
+        { return lhs.it >= rhs.it; }
+    };
+
+    // True if Fn is known to return its argument unchanged, so that
+    // map(f, first, last) is sequence(first, last).
+    template <typename Fn>
+    struct is_identity : std::false_type
+    {};
+
+#if defined(__cpp_lib_ranges)
+    template <>
+    struct is_identity<std::identity> : std::true_type
+    {};
+#endif
+
+    // Substitution fails unless values may be appended to a List in
+    // bulk, and space for them reserved in advance.
+    template <typename List, typename Iter>
+    using bulk_insert_t = decltype(
+        std::declval<List &>().reserve(std::size_t()),
+        std::declval<List &>().insert(
+            std::declval<List &>().end(),
+            std::declval<Iter>(),
+            std::declval<Iter>()
+        )
+    );
+
+    template <typename List, typename Iter, typename = void>
+    struct has_bulk_insert : std::false_type
+    {};
+
+    template <typename List, typename Iter>
+    struct has_bulk_insert<List, Iter, std::void_t<bulk_insert_t<List, Iter>>> :
+        std::true_type
+    {};
+
+    // True if sequence() over [first, last) may take the bulk path in
+    // bulk_sequence_impl(): the monads are contiguous and trivially
+    // copyable, their state is nothing but success or failure (see
+    // present_flag()), and their values may be appended to List in
+    // bulk.
+    template <typename Iter, typename List, typename State>
+    struct bulk_sequenceable :
+        std::conjunction<
+            is_contiguous_iterator<Iter>,
+            has_present_flag<State>,
+            std::integral_constant<
+                bool,
+                monad_traits<State>::trivially_relocatable
+            >,
+            std::is_trivially_copyable<
+                typename std::iterator_traits<Iter>::value_type
+            >,
+            std::negation<
+                std::is_reference<
+                    typename std::iterator_traits<Iter>::value_type::value_type
+                >
+            >,
+            has_bulk_insert<
+                List,
+                value_iterator<typename std::iterator_traits<Iter>::value_type>
+            >
+        >
+    {};
+
+    // sequence() over the n > 0 contiguous monads at first, with the same
+    // result as sequence_impl(), but a block at a time instead of through
+    // a loop of >>=: the states of a block are scanned for failure without
+    // branches, and then its values are appended to the result in one
+    // insert() while the block is still in cache.
+    template <typename List, typename State, typename Monad>
+    monad<List, State> bulk_sequence_impl (Monad const * first, std::size_t n)
+    {
+        constexpr std::size_t block_size = 256;
+
+        monad<List, State> retval{List{}, first->state()};
+        List & values = retval.mutable_value();
+        values.reserve(n);
+
+        std::size_t size = 0;
+        while (size < n) {
+            std::size_t const block_end =
+                n - size < block_size ? n : size + block_size;
+            unsigned char all_present = 1;
+            // The states are read in place through state_ref(); a copy
+            // returned by state() would be compared as a bool, which keeps
+            // the loop from being vectorized.
+            for (std::size_t i = size; i < block_end; ++i) {
+                all_present &= present_flag(first[i].state_ref());
+            }
+            std::size_t present_end = block_end;
+            if (!all_present) {
+                present_end = size;
+                while (present_flag(first[present_end].state_ref())) {
+                    ++present_end;
+                }
+                retval.mutable_state() = first[present_end].state();
+            }
+            values.insert(
+                values.end(),
+                value_iterator<Monad>{first + size},
+                value_iterator<Monad>{first + present_end}
+            );
+            if (!all_present)
+                break;
+            size = block_end;
+        }
+
+        return retval;
+    }
+
+    // The value of m, moved out of m if m is a non-const lvalue (that is,
+    // an element of a tuple that sequence() received as an rvalue), and
+    // otherwise as value() returns it.
+    template <typename Monad>
+    constexpr typename Monad::value_type && forward_value (Monad & m)
+    { return std::move(m.mutable_value()); }
+
+    template <typename Monad>
+    constexpr decltype(auto) forward_value (Monad const & m)
+    { return m.value(); }
+
+    // Like sequence_impl(), but over a tuple of monads with the same State,
+    // and producing a Result initialized from their values, as with
+    // Result{values...}.  For short-circuiting states, every state is
+    // checked before any value is touched, and nothing is allocated.
+    template <typename Result, typename State, typename Tuple, std::size_t ...Is>
+    constexpr monad<Result, State>
+    tuple_sequence_impl (Tuple & t, std::index_sequence<Is...>)
+    {
+        using result_type = monad<Result, State>;
+
+        using traits = monad_traits<State>;
+
+        State state = std::get<0>(t).state();
+        if constexpr (traits::state_independent_of_values) {
+            ((state = Is == 0 || traits::failed(state) ?
+                  state : traits::combine(state, std::get<Is>(t).state())), ...);
+        } else if constexpr (traits::short_circuits) {
+            // The state of the first failure, or of the last element.
+            ((state = traits::failed(state) ?
+                  state : std::get<Is>(t).state()), ...);
+        } else {
+            state = (... >> std::get<Is>(t)).state();
+        }
+        if (traits::failed(state))
+            return result_type{Result{}, state};
+
+        if constexpr (std::is_constructible<
+                          result_type,
+                          std::in_place_t,
+                          State,
+                          decltype(forward_value(std::get<Is>(t)))...
+                      >::value) {
+            return result_type{
+                std::in_place,
+                state,
+                forward_value(std::get<Is>(t))...
+            };
+        } else {
+            return result_type{Result{forward_value(std::get<Is>(t))...}, state};
+        }
+    }
+
+    // Applies f to each element of the tuple-like t, and collects the
+    // resulting monads in a std::tuple.  Braced initialization guarantees
+    // that f is applied in order.
+    template <typename Fn, typename Tuple, std::size_t ...Is>
+    constexpr auto tuple_map_impl (Fn & f, Tuple && t, std::index_sequence<Is...>)
+    {
+        using std::get;
+        return std::tuple<
+            typename std::remove_cv<
+                decltype(f(get<Is>(std::forward<Tuple>(t))))
+            >::type...
+        >{f(get<Is>(std::forward<Tuple>(t)))...};
+    }
+
+    template <typename Tuple>
+    using tuple_indices_t = std::make_index_sequence<
+        std::tuple_size<
+            typename std::remove_cv<
+                typename std::remove_reference<Tuple>::type
+            >::type
+        >::value
+    >;
+
+    // The element type of the lists that collect values of type T.
+    // References cannot be stored in containers, so a list of T & values
+    // holds std::reference_wrapper<T>.
+    template <typename T>
+    struct list_element
+    {
+        using type = T;
+    };
+
+    template <typename T>
+    struct list_element<T &>
+    {
+        using type = std::reference_wrapper<T>;
+    };
+
+    template <typename T>
+    using list_element_t = typename list_element<T>::type;
+
+    // The List type that ListSelector (e.g. small_list<N>) selects for
+    // elements of type T.  Substitution fails if ListSelector is not a
+    // list selector.
+    template <typename ListSelector, typename T>
+    using selected_list_t =
+        typename ListSelector::template list<list_element_t<T>>;
+
+    // The value type of the monad that Fn returns for an element of
+    // [first, last).  This is an alias rather than a class template so
+    // that an Fn that cannot be called this way is a substitution failure,
+    // e.g. when an explicit ListSelector argument is tried as the Fn of an
+    // overload that does not take one.
+    template <typename Fn, typename Iter>
+    using mapped_value_type_t = typename std::decay<
+        typename std::result_of<
+            Fn(typename std::iterator_traits<Iter>::value_type)
+        >::type
+    >::type::value_type;
+
+    template <typename Fn, typename Iter1, typename Iter2>
+    using zip_value_type_t = typename std::result_of<
+        Fn(
+            typename std::iterator_traits<Iter1>::value_type,
+            typename std::iterator_traits<Iter2>::value_type
+        )
+    >::type::value_type;
+
+    template <typename Iter1, typename Iter2>
+    struct zip_iterator
+    {
+        Iter1 first;
+        Iter2 second;
+
+        zip_iterator& operator++ ()
+        {
+            ++first;
+            ++second;
+            return *this;
+        }
+
+        friend bool operator== (zip_iterator lhs, zip_iterator rhs)
+        { return lhs.first == rhs.first; }
+        friend bool operator!= (zip_iterator lhs, zip_iterator rhs)
+        { return lhs.first != rhs.first; }
+    };
+
+} }
+
+namespace std {
+
+    template <typename Iter1, typename Iter2>
+    struct iterator_traits<monad::detail::zip_iterator<Iter1, Iter2>>
+    {
+        using iterator_category = random_access_iterator_tag;
+    };
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef DETAIL_CLOCK_CACHE_HPP_INCLUDED_
+#define DETAIL_CLOCK_CACHE_HPP_INCLUDED_
+
+#include <detail/detail.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace monad { namespace detail {
+
+    inline std::size_t hash_combine (std::size_t seed, std::size_t h)
+    { return seed ^ (h + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)); }
+
+    // Hashes a std::tuple<Ts...>, or any tuple of values convertible to
+    // Ts..., such as a tuple of references to them, to the same value.
+    template <typename Tuple>
+    struct tuple_hash;
+
+    template <typename ...Ts>
+    struct tuple_hash<std::tuple<Ts...>>
+    {
+        template <typename Tuple>
+        std::size_t operator() (Tuple const & t) const
+        {
+            return std::apply([](auto const & ...xs) {
+                std::size_t retval = 0;
+                using swallow = int[];
+                (void)swallow{0, (retval = hash_combine(retval, std::hash<Ts>{}(xs)), 0)...};
+                return retval;
+            }, t);
+        }
+    };
+
+    // Counters kept by clock_cache.
+    struct cache_counters
+    {
+        std::size_t hits;
+        std::size_t misses;
+        std::size_t evictions;
+        std::size_t size;
+    };
+
+    // A bounded map from Key to Value, split into independently locked
+    // shards.  Each shard evicts with the CLOCK algorithm: a hit marks its
+    // entry as referenced, and on insertion into a full shard the clock
+    // hand sweeps the entries, clearing reference marks, until it finds an
+    // unmarked entry to replace.  find() and insert() accept any key that
+    // Hash hashes as it would the equal Key, and that compares equal to it
+    // with ==, so that a Key need only be built for a new entry.
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class clock_cache
+    {
+    public:
+        clock_cache (std::size_t capacity, std::size_t shards) :
+            shards_ (round_up_to_power_of_two(shards ? shards : 1))
+        {
+            std::size_t const shard_capacity =
+                (capacity + shards_.size() - 1) / shards_.size();
+            for (auto & shard : shards_) {
+                shard.capacity_ = shard_capacity ? shard_capacity : 1;
+                shard.entries_.reserve(shard.capacity_);
+                shard.index_.reserve(shard.capacity_);
+            }
+        }
+
+        // Copies the cached value for key into value and returns true, or
+        // returns false on a miss.
+        template <typename LookupKey>
+        bool find (LookupKey const & key, Value & value)
+        {
+            std::size_t const h = Hash{}(key);
+            shard & s = shard_for(h);
+            std::lock_guard<std::mutex> lock(s.mutex_);
+            std::size_t const i = find_entry(s, h, key);
+            if (i == s.entries_.size()) {
+                ++s.misses_;
+                return false;
+            }
+            entry & e = s.entries_[i];
+            e.referenced_ = true;
+            value = e.value_;
+            ++s.hits_;
+            return true;
+        }
+
+        template <typename LookupKey>
+        void insert (LookupKey const & key, Value const & value)
+        {
+            std::size_t const h = Hash{}(key);
+            shard & s = shard_for(h);
+            std::lock_guard<std::mutex> lock(s.mutex_);
+
+            std::size_t const i = find_entry(s, h, key);
+            if (i != s.entries_.size()) {
+                s.entries_[i].value_ = value;
+                return;
+            }
+
+            if (s.entries_.size() < s.capacity_) {
+                s.entries_.push_back(entry{Key(key), value, h, false});
+                s.index_.emplace(h, s.entries_.size() - 1);
+                return;
+            }
+
+            while (s.entries_[s.hand_].referenced_) {
+                s.entries_[s.hand_].referenced_ = false;
+                s.hand_ = (s.hand_ + 1) % s.capacity_;
+            }
+            entry & victim = s.entries_[s.hand_];
+            auto it = s.index_.find(victim.hash_);
+            while (it->second != s.hand_) {
+                ++it;
+            }
+            s.index_.erase(it);
+            victim.key_ = Key(key);
+            victim.value_ = value;
+            victim.hash_ = h;
+            s.index_.emplace(h, s.hand_);
+            s.hand_ = (s.hand_ + 1) % s.capacity_;
+            ++s.evictions_;
+        }
+
+        cache_counters counters () const
+        {
+            cache_counters retval = {0, 0, 0, 0};
+            for (auto const & s : shards_) {
+                std::lock_guard<std::mutex> lock(s.mutex_);
+                retval.hits += s.hits_;
+                retval.misses += s.misses_;
+                retval.evictions += s.evictions_;
+                retval.size += s.entries_.size();
+            }
+            return retval;
+        }
+
+        void clear ()
+        {
+            for (auto & s : shards_) {
+                std::lock_guard<std::mutex> lock(s.mutex_);
+                s.entries_.clear();
+                s.index_.clear();
+                s.hand_ = 0;
+            }
+        }
+
+    private:
+        struct entry
+        {
+            Key key_;
+            Value value_;
+            std::size_t hash_;
+            bool referenced_;
+        };
+
+        struct alignas(cache_line_size) shard
+        {
+            mutable std::mutex mutex_;
+            std::vector<entry> entries_;
+            // From the hashes of the keys to their entries.
+            std::unordered_multimap<std::size_t, std::size_t> index_;
+            std::size_t capacity_ = 0;
+            std::size_t hand_ = 0;
+            std::size_t hits_ = 0;
+            std::size_t misses_ = 0;
+            std::size_t evictions_ = 0;
+        };
+
+        // The index of the entry for key, whose hash is h, in s, or
+        // s.entries_.size() if there is none.
+        template <typename LookupKey>
+        static std::size_t find_entry (
+            shard const & s,
+            std::size_t h,
+            LookupKey const & key
+        ) {
+            auto const range = s.index_.equal_range(h);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (s.entries_[it->second].key_ == key)
+                    return it->second;
+            }
+            return s.entries_.size();
+        }
+
+        // The low bits of h also select the bucket within the shard's map,
+        // and std::hash is the identity for integers in some
+        // implementations, so the shard is chosen from the high bits of a
+        // multiplicative hash of h.
+        shard & shard_for (std::size_t h)
+        {
+            std::uint64_t const mixed = h * 0x9e3779b97f4a7c15ull;
+            return shards_[(mixed >> 40) & (shards_.size() - 1)];
+        }
+
+        std::vector<shard> shards_;
+    };
+
+} }
+
+#endif
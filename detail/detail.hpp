@@ -2,12 +2,29 @@
 #define DETAIL_HPP_INCLUDED_
 
 #include <monad_fwd.hpp>
+#include <monad_traits.hpp>
+#include <detail/lift_n_impl.hpp>
+#include <cstddef>
+#include <tuple>
 #include <type_traits>
-#include <iterator>
 
 
 namespace monad { namespace detail {
 
+    // Used to keep data written by different threads on separate cache
+    // lines.
+    inline constexpr std::size_t cache_line_size = 64;
+
+    // The smallest power of two that is at least n, or 1 if n is 0.
+    inline std::size_t round_up_to_power_of_two (std::size_t n)
+    {
+        std::size_t retval = 1;
+        while (retval < n) {
+            retval *= 2;
+        }
+        return retval;
+    }
+
     template <typename Monad>
     struct state_type
     {
@@ -21,127 +38,71 @@ namespace monad { namespace detail {
     };
 
     template <typename Monad>
-    using state_type_t = typename state_type<Monad>::type;
-
-    template <std::size_t N,
-              typename ReturnMonad,
-              typename Fn,
-              typename ...Monads>
-    struct lift_n_impl;
-
-#define MONAD_LIFT_N_MAX_ARITY 10
-#include "detail/lift_n_impl.hpp"
-
-    template <typename Container, typename Iter, typename Tag>
-    void reserve_impl (Container&, Iter, Iter, Tag)
-    {}
-
-    template <typename Container, typename Iter>
-    auto reserve_impl (Container& c,
-                       Iter first,
-                       Iter last,
-                       std::random_access_iterator_tag) ->
-        decltype(c.reserve(last - first)) // For SFINAE.
-    { c.reserve(last - first); }
-
-    template <typename Container, typename Iter>
-    void reserve (Container& c, Iter first, Iter last)
-    {
-        reserve_impl(
-            c,
-            first,
-            last,
-            typename std::iterator_traits<Iter>::iterator_category{}
-        );
-    }
-
-    template <
-        typename Iter,
-        typename Monad,
-        typename List,
-        typename State,
-        typename Fn
-    >
-    monad<List, State> sequence_impl (Fn f, Iter first, Iter last)
+    using state_type_t =
+        typename state_type<typename std::decay<Monad>::type>::type;
+
+    // The decayed parameter types of a non-generic callable, as a
+    // tuple.
+    template <typename Fn>
+    struct callable_params :
+        callable_params<decltype(&Fn::operator())>
+    {};
+
+    template <typename R, typename ...Args>
+    struct callable_params<R (Args...)>
     {
-        if (first == last)
-            return monad<List, State>{};
-
-        monad<List, State> retval{List{}};
-
-        detail::reserve(retval.mutable_value(), first, last);
-
-        Monad prev = f(first);
-        ++first;
-        retval.mutable_value().push_back(prev.value());
-
-        while (first != last) {
-            Monad m = f(first);
-            ++first;
-            retval.mutable_value().push_back(m.value());
-            prev = prev >>= [=](typename Monad::value_type) {
-                return m;
-            };
-        }
-
-        retval.mutable_state() = prev.state();
-
-        return retval;
-    }
-
-    template <typename Fn, typename Iter>
-    struct mapped_value_type
-    {
-        using type = typename std::result_of<
-            Fn(typename Iter::value_type)
-        >::type::value_type;
-    };
-
-    template <typename Fn, typename Iter>
-    using mapped_value_type_t =
-        typename mapped_value_type<Fn, Iter>::type;
-
-    template <typename Fn, typename Iter1, typename Iter2>
-    struct zip_value_type
-    {
-        using type = typename std::result_of<
-            Fn(typename Iter1::value_type, typename Iter2::value_type)
-        >::type::value_type;
+        using type = std::tuple<typename std::decay<Args>::type...>;
     };
 
-    template <typename Fn, typename Iter1, typename Iter2>
-    using zip_value_type_t =
-        typename zip_value_type<Fn, Iter1, Iter2>::type;
-
-    template <typename Iter1, typename Iter2>
-    struct zip_iterator
+    template <typename R, typename ...Args>
+    struct callable_params<R (*)(Args...)> :
+        callable_params<R (Args...)>
+    {};
+
+    template <typename C, typename R, typename ...Args>
+    struct callable_params<R (C::*)(Args...)> :
+        callable_params<R (Args...)>
+    {};
+
+    template <typename C, typename R, typename ...Args>
+    struct callable_params<R (C::*)(Args...) const> :
+        callable_params<R (Args...)>
+    {};
+
+    template <typename R, typename ...Args>
+    struct callable_params<R (*)(Args...) noexcept> :
+        callable_params<R (Args...)>
+    {};
+
+    template <typename C, typename R, typename ...Args>
+    struct callable_params<R (C::*)(Args...) const noexcept> :
+        callable_params<R (Args...)>
+    {};
+
+    // Applies the functions I through N - 1 in the tuple fns to the result
+    // m of the previous stage.  Each stage's continuation is the rest of the
+    // composition, so a failing stage returns the final stage's failure
+    // directly, without building the intermediate results.
+    template <std::size_t I, std::size_t N>
+    struct kleisli_apply
     {
-        Iter1 first;
-        Iter2 second;
-
-        zip_iterator& operator++ ()
+        template <typename Fns, typename Monad>
+        static constexpr auto call (Fns const & fns, Monad m)
         {
-            ++first;
-            ++second;
-            return *this;
+            return m >>= [&fns](typename Monad::value_type x) {
+                return kleisli_apply<I + 1, N>::call(fns, std::get<I>(fns)(x));
+            };
         }
-
-        friend bool operator== (zip_iterator lhs, zip_iterator rhs)
-        { return lhs.first == rhs.first; }
-        friend bool operator!= (zip_iterator lhs, zip_iterator rhs)
-        { return lhs.first != rhs.first; }
     };
 
-} }
-
-namespace std {
-
-    template <typename Iter1, typename Iter2>
-    struct iterator_traits<monad::detail::zip_iterator<Iter1, Iter2>>
+    template <std::size_t N>
+    struct kleisli_apply<N, N>
     {
-        using iterator_category = random_access_iterator_tag;
+        template <typename Fns, typename Monad>
+        static constexpr Monad call (Fns const &, Monad m)
+        { return m; }
     };
 
-}
+} }
 
 #endif
@@ -1,48 +1,102 @@
-#if !BOOST_PP_IS_ITERATING
-
-#  include <boost/preprocessor/repetition/enum.hpp>
-#  include <boost/preprocessor/repetition/enum_params.hpp>
-#  include <boost/preprocessor/repetition/enum_binary_params.hpp>
-#  include <boost/preprocessor/repetition/repeat.hpp>
-#  include <boost/preprocessor/iteration/iterate.hpp>
-
-#  define BOOST_PP_FILENAME_1 "detail/lift_n_impl.hpp"
-#  define BOOST_PP_ITERATION_LIMITS (1, MONAD_LIFT_N_MAX_ARITY)
-#  include BOOST_PP_ITERATE()
-
-#else
-
-#  define N BOOST_PP_ITERATION()
-#  define OPEN(_1, N, _3) return m##N >>= [=](typename M##N::value_type _##N) {
-#  define CLOSE(_1, _2, _3) };
-
-    template <typename ReturnMonad,
-              typename Fn,
-              BOOST_PP_ENUM_PARAMS(N, typename M)>
-    struct lift_n_impl<N,
-                       ReturnMonad,
-                       Fn,
-                       BOOST_PP_ENUM_PARAMS(N, M)>
+#ifndef DETAIL_LIFT_N_IMPL_HPP_INCLUDED_
+#define DETAIL_LIFT_N_IMPL_HPP_INCLUDED_
+
+#include <monad_traits.hpp>
+
+#include <type_traits>
+
+
+namespace monad { namespace detail {
+
+    // Values... are the already-unwrapped values of the monads to the left
+    // of the remaining parameters of call().  Without the recursion,
+    // lift_n_impl<ReturnMonad>::call(f, m0, m1, ...) looks something like:
+    // return m0 >>= [=](typename M0::value_type _0) {
+    //    return m1 >>= [=](typename M1::value_type _1) {
+    //        ...
+    //            return ReturnMonad{f(_0, _1, ...))};
+    //        ...
+    //    };
+    // };
+    // The values are captured by reference, so that value types that are
+    // references (as with maybe<T &>) are passed along without copying.
+    template <typename ReturnMonad, typename ...Values>
+    struct lift_n_impl
     {
-        // Without all the noise below, call() looks something like:
-        // return m0 >>= [=](typename M0::value_type _0) {
-        //    return m1 >>= [=](typename M1::value_type _1) {
-        //        ...
-        //            return ReturnMonad{f(_0, _1, ...))};
-        //        ...
-        //    };
-        // };
-        static ReturnMonad call (Fn f,
-                                 BOOST_PP_ENUM_BINARY_PARAMS(N, M, m))
-        {
-            BOOST_PP_REPEAT(N, OPEN, _)
-                return ReturnMonad{f(BOOST_PP_ENUM_PARAMS(N, _))};
-            BOOST_PP_REPEAT(N, CLOSE, _);
+        template <typename Fn>
+        static constexpr ReturnMonad call (Fn f, Values... values)
+        { return ReturnMonad{f(values...)}; }
+
+        template <typename Fn, typename Monad, typename ...Monads>
+        static constexpr ReturnMonad call (
+            Fn f,
+            Values... values,
+            Monad m,
+            Monads... monads
+        ) {
+            return m >>= [f, &values..., monads...](
+                typename Monad::value_type x
+            ) {
+                return lift_n_impl<
+                    ReturnMonad,
+                    Values...,
+                    typename Monad::value_type
+                >::call(f, values..., x, monads...);
+            };
         }
     };
 
-#  undef OPEN
-#  undef CLOSE
-#  undef N
+    // True if lift_n<ReturnMonad>() may combine the states of its
+    // arguments in one pass with monad_traits<>::combine() instead of
+    // through nested >>=: every argument has ReturnMonad's state, and that
+    // state's traits set state_independent_of_values.
+    template <typename ReturnMonad, typename ...Monads>
+    struct lift_n_combinable :
+        std::integral_constant<
+            bool,
+            0 < sizeof...(Monads) &&
+            (std::is_same<
+                 typename Monads::state_type,
+                 typename ReturnMonad::state_type
+             >::value && ...) &&
+            monad_traits<
+                typename ReturnMonad::state_type
+            >::state_independent_of_values &&
+            !std::is_reference<typename ReturnMonad::value_type>::value
+        >
+    {};
+
+    // lift_n() for the states described by lift_n_combinable.  For
+    // short-circuiting states, the states after the first failure are not
+    // combined, and f is not called.
+    template <
+        typename ReturnMonad,
+        typename Fn,
+        typename Monad,
+        typename ...Monads
+    >
+    constexpr ReturnMonad lift_n_combined (
+        Fn f,
+        Monad const & m,
+        Monads const &... monads
+    ) {
+        using state_type = typename ReturnMonad::state_type;
+        using traits = monad_traits<state_type>;
+
+        state_type state = m.state();
+        ((state = traits::failed(state) ?
+              state : traits::combine(state, monads.state())), ...);
+        if (traits::failed(state)) {
+            ReturnMonad retval;
+            retval.mutable_state() = state;
+            return retval;
+        }
+
+        ReturnMonad retval{f(m.value(), monads.value()...)};
+        retval.mutable_state() = traits::combine(state, retval.state());
+        return retval;
+    }
+
+} }
 
 #endif
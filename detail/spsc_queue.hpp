@@ -0,0 +1,95 @@
+#ifndef DETAIL_SPSC_QUEUE_HPP_INCLUDED_
+#define DETAIL_SPSC_QUEUE_HPP_INCLUDED_
+
+#include <detail/detail.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace monad { namespace detail {
+
+    // A bounded, lock-free, single-producer single-consumer ring buffer.
+    // try_push() may only be called from one thread, and try_pop() from
+    // one other thread.  T must be default constructible and move
+    // assignable.  The capacity is rounded up to a power of two.
+    template <typename T>
+    class spsc_queue
+    {
+    public:
+        using value_type = T;
+
+        explicit spsc_queue (std::size_t capacity) :
+            slots_ (round_up_to_power_of_two(capacity)),
+            mask_ (slots_.size() - 1)
+        {}
+
+        spsc_queue (spsc_queue const &) = delete;
+        spsc_queue & operator= (spsc_queue const &) = delete;
+
+        std::size_t capacity () const
+        { return slots_.size(); }
+
+        bool try_push (T && x)
+        {
+            std::size_t const tail = producer_.tail_.load(std::memory_order_relaxed);
+            if (tail - producer_.head_cache_ == slots_.size()) {
+                producer_.head_cache_ =
+                    consumer_.head_.load(std::memory_order_acquire);
+                if (tail - producer_.head_cache_ == slots_.size())
+                    return false;
+            }
+            slots_[tail & mask_] = std::move(x);
+            producer_.tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop (T & x)
+        {
+            std::size_t const head = consumer_.head_.load(std::memory_order_relaxed);
+            if (head == consumer_.tail_cache_) {
+                consumer_.tail_cache_ =
+                    producer_.tail_.load(std::memory_order_acquire);
+                if (head == consumer_.tail_cache_)
+                    return false;
+            }
+            x = std::move(slots_[head & mask_]);
+            consumer_.head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Called by the producer after its last try_push().
+        void close ()
+        { closed_.store(true, std::memory_order_release); }
+
+        bool closed () const
+        { return closed_.load(std::memory_order_acquire); }
+
+    private:
+        // The producer and consumer each keep a cached copy of the other's
+        // index, so that the shared cache lines are only read when the
+        // queue looks full or empty.
+        struct alignas(cache_line_size) producer_side
+        {
+            std::atomic<std::size_t> tail_{0};
+            std::size_t head_cache_ = 0;
+        };
+
+        struct alignas(cache_line_size) consumer_side
+        {
+            std::atomic<std::size_t> head_{0};
+            std::size_t tail_cache_ = 0;
+        };
+
+        std::vector<T> slots_;
+        std::size_t mask_;
+        producer_side producer_;
+        consumer_side consumer_;
+        alignas(cache_line_size) std::atomic<bool> closed_{false};
+    };
+
+} }
+
+#endif
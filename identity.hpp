@@ -0,0 +1,125 @@
+#ifndef IDENTITY_HPP_INCLUDED_
+#define IDENTITY_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+
+#include <type_traits>
+#include <utility>
+
+
+namespace monad {
+
+    namespace detail {
+
+        // The state of identity, which carries no information.
+        struct identity_state {};
+
+        constexpr bool operator== (identity_state, identity_state)
+        { return true; }
+
+        // See present_flag(maybe_state const &).
+        constexpr unsigned char present_flag (identity_state const &)
+        { return 1; }
+
+    }
+
+    template <>
+    struct monad_traits<detail::identity_state> :
+        default_monad_traits<detail::identity_state>
+    {
+        static constexpr bool state_independent_of_values = true;
+        static constexpr bool associative_combine = true;
+
+        static constexpr detail::identity_state
+        combine (detail::identity_state, detail::identity_state)
+        { return {}; }
+    };
+
+    /** The identity monad: a value, and nothing else.  bind(f) is
+        f(value()).  An identity<T> is the same size as a T, and the
+        algorithms compile to plain loops over its values.  It is the
+        reference implementation of a monad that gets the algorithms' fast
+        paths through its monad_traits alone. */
+    template <typename T>
+    class monad<T, detail::identity_state>
+    {
+    public:
+        using this_type = monad<T, detail::identity_state>;
+        using value_type = T;
+        using state_type = detail::identity_state;
+
+    private:
+        value_type value_;
+        [[no_unique_address]] state_type state_;
+
+    public:
+        constexpr monad ()
+            noexcept(std::is_nothrow_default_constructible<value_type>::value) :
+            value_ {},
+            state_ {}
+        {}
+
+        constexpr monad (value_type value, state_type)
+            noexcept(std::is_nothrow_move_constructible<value_type>::value) :
+            value_ {std::move(value)},
+            state_ {}
+        {}
+
+        constexpr monad (value_type t)
+            noexcept(std::is_nothrow_move_constructible<value_type>::value) :
+            value_ {std::move(t)},
+            state_ {}
+        {}
+
+        template <typename ...Args>
+        constexpr monad (std::in_place_t, state_type, Args &&... args) :
+            value_ {std::forward<Args>(args)...},
+            state_ {}
+        {}
+
+        monad (const monad& rhs) = default;
+        monad (monad&& rhs) = default;
+        monad& operator= (const monad& rhs) = default;
+        monad& operator= (monad&& rhs) = default;
+        ~monad () = default;
+
+        constexpr value_type const & value () const &
+        { return value_; }
+
+        constexpr value_type value () &&
+        { return std::move(value_); }
+
+        constexpr state_type state () const
+        { return {}; }
+
+        // The state, by reference, for loops that read it in place;
+        // state() returns a copy.
+        constexpr state_type const & state_ref () const
+        { return state_; }
+
+        template <typename Fn>
+        constexpr auto bind (Fn f) const ->
+            typename std::remove_cv<decltype(f(value_))>::type
+        { return f(value_); }
+
+        template <typename Fn>
+        constexpr this_type fmap (Fn f)
+        { return this_type{f(value_)}; }
+
+        // Requires that value_type be an identity.
+        constexpr value_type join () const
+        { return value_; }
+
+        constexpr value_type & mutable_value ()
+        { return value_; }
+
+        constexpr state_type & mutable_state ()
+        { return state_; }
+    };
+
+    template <typename T>
+    using identity = monad<T, detail::identity_state>;
+
+}
+
+#endif
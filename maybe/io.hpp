@@ -3,7 +3,10 @@
 
 #include <maybe/maybe.hpp>
 
+#include <array>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 
 namespace monad {
@@ -33,6 +36,21 @@ namespace monad {
         return os;
     }
 
+    template <typename T, std::size_t N>
+    std::ostream& operator<< (std::ostream& os, maybe<std::array<T, N>> m)
+    {
+        if (!m.state().nonempty_) {
+            os << "Nothing";
+        } else {
+            os << "Just [ ";
+            for (auto && v : m.value()) {
+                os << v << " ";
+            }
+            os << "]";
+        }
+        return os;
+    }
+
     template <typename T, typename U>
     std::ostream& operator<< (
         std::ostream& os,
@@ -57,6 +75,9 @@ namespace monad {
     inline std::ostream& operator<< (std::ostream& os, nothing_t)
     { return os << "Nothing"; }
 
+    inline std::ostream& operator<< (std::ostream& os, unit)
+    { return os << "()"; }
+
 }
 
 #endif
@@ -1,25 +1,49 @@
 #ifndef MAYBE_MAYBE_HPP_INCLUDED_
 #define MAYBE_MAYBE_HPP_INCLUDED_
 
-#include <monad.hpp>
+#include <maybe/maybe_fwd.hpp>
+#include <monad_core.hpp>
+
+#include <memory>
 
 
 namespace monad {
 
     namespace detail {
 
-        struct maybe_state
-        {
-            bool nonempty_;
-        };
-
-        bool operator== (maybe_state lhs, maybe_state rhs)
+        constexpr bool operator== (maybe_state lhs, maybe_state rhs)
         { return lhs.nonempty_ == rhs.nonempty_; }
 
+        // 1 if state has not failed.  The bulk paths of the algorithms scan
+        // contiguous monads with this rather than with
+        // monad_traits<>::failed(), since it reads the flag in place and
+        // does no bool arithmetic, so that the scan vectorizes.  It is
+        // defined only for states that hold nothing but success or
+        // failure, so that any successful state is the combination of all
+        // of them.
+        constexpr unsigned char present_flag (maybe_state const & state)
+        { return state.nonempty_; }
+
     }
 
-    struct nothing_t {};
-    const nothing_t nothing = {};
+    template <>
+    struct monad_traits<detail::maybe_state> :
+        default_monad_traits<detail::maybe_state>
+    {
+        static constexpr bool short_circuits = true;
+
+        static constexpr bool failed (detail::maybe_state state)
+        { return !state.nonempty_; }
+
+        static constexpr bool state_independent_of_values = true;
+        static constexpr bool associative_combine = true;
+
+        static constexpr detail::maybe_state
+        combine (detail::maybe_state lhs, detail::maybe_state rhs)
+        { return {lhs.nonempty_ && rhs.nonempty_}; }
+    };
+
+    inline constexpr nothing_t nothing = {};
 
     template <typename T>
     class monad<T, detail::maybe_state>
@@ -34,37 +58,66 @@ namespace monad {
         state_type state_;
 
     public:
-        monad () :
+        constexpr monad ()
+            noexcept(std::is_nothrow_default_constructible<value_type>::value) :
             value_ {},
             state_ {false}
         {}
 
-        monad (value_type value, state_type state) :
-            value_ {value},
+        constexpr monad (value_type value, state_type state)
+            noexcept(std::is_nothrow_move_constructible<value_type>::value) :
+            value_ {std::move(value)},
             state_ (state)
         {}
 
-        monad (value_type t) :
-            value_ {t},
+        constexpr monad (value_type t)
+            noexcept(std::is_nothrow_move_constructible<value_type>::value) :
+            value_ {std::move(t)},
             state_ {true}
         {}
 
-        monad (nothing_t) :
+        // Constructs the value in place, as with value_type{args...}, so
+        // that e.g. the elements of a tuple payload are each moved once.
+        template <typename ...Args>
+        constexpr monad (std::in_place_t, state_type state, Args &&... args) :
+            value_ {std::forward<Args>(args)...},
+            state_ (state)
+        {}
+
+        constexpr monad (nothing_t)
+            noexcept(std::is_nothrow_default_constructible<value_type>::value) :
             value_ {},
             state_ {false}
         {}
 
+        // The special members are defaulted so that they are trivial, and
+        // noexcept, exactly when value_type's are.  In particular, maybe<T>
+        // is trivially copyable (and so may be relocated with memcpy())
+        // whenever T is.
         monad (const monad& rhs) = default;
+        monad (monad&& rhs) = default;
         monad& operator= (const monad& rhs) = default;
+        monad& operator= (monad&& rhs) = default;
+        ~monad () = default;
 
-        value_type value () const
+        // value() does not copy the payload, except when it is called on an
+        // rvalue, when the payload is moved out.
+        constexpr value_type const & value () const &
         { return value_; }
 
-        state_type state () const
+        constexpr value_type value () &&
+        { return std::move(value_); }
+
+        constexpr state_type state () const
+        { return state_; }
+
+        // The state, by reference, for loops that read it in place;
+        // state() returns a copy.
+        constexpr state_type const & state_ref () const
         { return state_; }
 
         template <typename Fn>
-        auto bind (Fn f) const ->
+        constexpr auto bind (Fn f) const ->
             typename std::remove_cv<decltype(f(value_))>::type
         {
             using result_type =
@@ -76,28 +129,90 @@ namespace monad {
         }
 
         template <typename Fn>
-        this_type fmap (Fn f)
+        constexpr this_type fmap (Fn f)
         {
             return bind([f](value_type x) {
                 return this_type{f(x)};
             });
         }
 
-        value_type join() const
+        constexpr value_type join() const
         { return !state_.nonempty_ ? nothing : value_; }
 
-        value_type & mutable_value ()
+        constexpr value_type & mutable_value ()
         { return value_; }
 
-        state_type & mutable_state ()
+        constexpr state_type & mutable_state ()
         { return state_; }
     };
 
+    /** A maybe that refers to, rather than holds, its value.  It is a
+        single nullable pointer; bind() and value() yield the referred-to
+        object itself, so lookups into large containers can be chained with
+        >>= without copying the elements they find.  As with a raw pointer,
+        the referred-to object must outlive the maybe.  The algorithms that
+        collect values, such as sequence() and map(), produce lists of
+        std::reference_wrapper<T> from a maybe<T&>. */
     template <typename T>
-    using maybe = monad<T, detail::maybe_state>;
+    class monad<T &, detail::maybe_state>
+    {
+    public:
+        using this_type = monad<T &, detail::maybe_state>;
+        using value_type = T &;
+        using state_type = detail::maybe_state;
+
+    private:
+        T * ptr_;
+
+    public:
+        constexpr monad () noexcept :
+            ptr_ (nullptr)
+        {}
+
+        constexpr monad (value_type value, state_type state) noexcept :
+            ptr_ (state.nonempty_ ? std::addressof(value) : nullptr)
+        {}
+
+        constexpr monad (value_type value) noexcept :
+            ptr_ (std::addressof(value))
+        {}
+
+        // Binding to a temporary would leave the pointer dangling.
+        monad (T &&) = delete;
+
+        constexpr monad (nothing_t) noexcept :
+            ptr_ (nullptr)
+        {}
+
+        constexpr value_type value () const
+        { return *ptr_; }
+
+        constexpr state_type state () const
+        { return state_type{ptr_ != nullptr}; }
+
+        template <typename Fn>
+        constexpr auto bind (Fn f) const ->
+            typename std::remove_cv<decltype(f(*ptr_))>::type
+        {
+            using result_type =
+                typename std::remove_cv<decltype(f(*ptr_))>::type;
+            if (!ptr_)
+                return result_type{nothing};
+            else
+                return f(*ptr_);
+        }
+
+        template <typename Fn>
+        constexpr this_type fmap (Fn f)
+        {
+            return bind([f](value_type x) {
+                return this_type{f(x)};
+            });
+        }
+    };
 
     template <typename T>
-    bool operator== (maybe<T> lhs, maybe<T> rhs)
+    constexpr bool operator== (maybe<T> const & lhs, maybe<T> const & rhs)
     {
         return
             lhs.state() == rhs.state() &&
@@ -105,19 +220,19 @@ namespace monad {
     }
 
     template <typename T>
-    bool operator== (maybe<T> lhs, nothing_t)
+    constexpr bool operator== (maybe<T> const & lhs, nothing_t)
     { return !lhs.state().nonempty_; }
 
     template <typename T>
-    bool operator== (nothing_t n, maybe<T> m)
+    constexpr bool operator== (nothing_t n, maybe<T> const & m)
     { return m == n; }
 
     template <typename T>
-    bool operator!= (maybe<T> m, nothing_t n)
+    constexpr bool operator!= (maybe<T> const & m, nothing_t n)
     { return !(m == n); }
 
     template <typename T>
-    bool operator!= (nothing_t n, maybe<T> m)
+    constexpr bool operator!= (nothing_t n, maybe<T> const & m)
     { return !(m == n); }
 
 }
@@ -0,0 +1,25 @@
+#ifndef MAYBE_MAYBE_FWD_HPP_INCLUDED_
+#define MAYBE_MAYBE_FWD_HPP_INCLUDED_
+
+#include <monad_fwd.hpp>
+
+
+namespace monad {
+
+    namespace detail {
+
+        struct maybe_state
+        {
+            bool nonempty_;
+        };
+
+    }
+
+    struct nothing_t {};
+
+    template <typename T>
+    using maybe = monad<T, detail::maybe_state>;
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef MEMOIZE_HPP_INCLUDED_
+#define MEMOIZE_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+#include <detail/clock_cache.hpp>
+
+#include <memory>
+#include <tuple>
+#include <type_traits>
+
+
+namespace monad {
+
+    /** Options for memoize(). */
+    struct memoize_options
+    {
+        /** The number of independently locked parts of the cache.  Rounded
+            up to a power of two. */
+        std::size_t shards = 16;
+
+        /** Whether to cache results whose state is a failure (e.g.
+            nothing).  Only meaningful for short-circuiting states. */
+        bool cache_failures = true;
+    };
+
+    /** Counters for a memoized function's cache. */
+    struct memoize_stats
+    {
+        std::size_t hits;
+        std::size_t misses;
+        std::size_t evictions;
+        std::size_t size;
+
+        double hit_rate () const
+        { return hits + misses ? double(hits) / (hits + misses) : 0.0; }
+    };
+
+    namespace detail {
+
+        template <typename T>
+        constexpr bool result_failed (T const &)
+        { return false; }
+
+        template <typename T, typename State>
+        constexpr bool result_failed (monad<T, State> const & m)
+        { return monad_traits<State>::failed(m.state()); }
+
+    }
+
+    /** A function object that caches the results of a pure function @c Fn
+        of @c Args....  Copies share the same cache, which is bounded, and
+        is safe to use from several threads at once, e.g. from reduce().
+        The result type must be default constructible and copyable. */
+    template <typename Fn, typename ...Args>
+    class memoized
+    {
+    public:
+        using key_type = std::tuple<Args...>;
+        using result_type = typename std::decay<
+            decltype(std::declval<Fn const &>()(std::declval<Args const &>()...))
+        >::type;
+
+        memoized (Fn f, std::size_t capacity, memoize_options options) :
+            f_ (f),
+            cache_ (std::make_shared<cache_type>(capacity, options.shards)),
+            cache_failures_ (options.cache_failures)
+        {}
+
+        result_type operator() (Args const & ...args) const
+        {
+            // The arguments are looked up in place; a key_type is built
+            // from them only if the result is inserted.
+            auto const key = std::forward_as_tuple(args...);
+            result_type retval;
+            if (cache_->find(key, retval))
+                return retval;
+            retval = f_(args...);
+            if (cache_failures_ || !detail::result_failed(retval))
+                cache_->insert(key, retval);
+            return retval;
+        }
+
+        memoize_stats stats () const
+        {
+            detail::cache_counters const c = cache_->counters();
+            return memoize_stats{c.hits, c.misses, c.evictions, c.size};
+        }
+
+        void clear ()
+        { cache_->clear(); }
+
+    private:
+        using cache_type = detail::clock_cache<
+            key_type,
+            result_type,
+            detail::tuple_hash<key_type>
+        >;
+
+        Fn f_;
+        std::shared_ptr<cache_type> cache_;
+        bool cache_failures_;
+    };
+
+    namespace detail {
+
+        template <typename Fn, typename ...Args>
+        memoized<Fn, Args...> make_memoized (
+            Fn f,
+            std::size_t capacity,
+            memoize_options options,
+            std::tuple<Args...> *
+        ) {
+            return memoized<Fn, Args...>(f, capacity, options);
+        }
+
+    }
+
+    /** Returns a memoized version of @c f that caches up to @c capacity
+        results, keyed on its arguments.  The result may be used wherever
+        @c f could: with >>=, map(), fold(), lift_n(), etc.  The argument
+        types are deduced from @c f's signature; for generic lambdas or
+        overloaded function objects, specify them explicitly, as in
+        <c>memoize<std::string>(f, 1024)</c>.  The cache may be shared by
+        concurrent callers, so @c f must be safe to call concurrently. */
+    template <typename ...Args, typename Fn>
+    auto memoize (Fn f, std::size_t capacity, memoize_options options = {})
+    {
+        if constexpr (sizeof...(Args) == 0) {
+            using params = typename detail::callable_params<Fn>::type;
+            return detail::make_memoized(
+                f,
+                capacity,
+                options,
+                static_cast<params *>(nullptr)
+            );
+        } else {
+            return memoized<Fn, Args...>(f, capacity, options);
+        }
+    }
+
+}
+
+#endif
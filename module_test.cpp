@@ -0,0 +1,64 @@
+// A consumer of the monad module: it imports the module instead of
+// including the headers, and exercises a few of its exports.  It is the
+// module's only importer, and fails to compile if an export is missing.
+// Build with a compiler that supports importing named modules, e.g.:
+//     g++ -std=c++20 -fmodules-ts -I. -x c++ -c monad.cppm -o monad.o
+//     g++ -std=c++20 -fmodules-ts -I. module_test.cpp monad.o -o module_test
+//     ./module_test
+// It exits with a nonzero status if a check fails.  GCC 12 compiles the
+// interface unit, but fails to import it.
+
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+import monad;
+
+
+namespace {
+
+    int failures = 0;
+
+    void check (bool ok, char const * what)
+    {
+        if (!ok) {
+            std::printf("module_test: check failed: %s\n", what);
+            ++failures;
+        }
+    }
+
+    monad::maybe<int> checked_half (int x)
+    { return x % 2 ? monad::maybe<int>{monad::nothing} : monad::maybe<int>{x / 2}; }
+
+}
+
+int main ()
+{
+    std::vector<int> const evens = {2, 4, 8};
+    std::vector<int> const mixed = {2, 3, 4};
+
+    check(
+        monad::map(checked_half, evens) == monad::maybe<std::vector<int>>{{1, 2, 4}},
+        "map"
+    );
+    check(monad::map(checked_half, mixed) == monad::nothing, "map, failing");
+
+    auto add = [](int x, int y) {return monad::maybe<int>{x + y};};
+    check(monad::fold(add, 0, evens) == monad::maybe<int>{14}, "fold");
+    check(
+        monad::reduce(monad::seq, add, 0, evens) == monad::maybe<int>{14},
+        "reduce"
+    );
+
+    auto const quarter = monad::compose_k(checked_half, checked_half);
+    check(quarter(8) == monad::maybe<int>{2}, "compose_k");
+
+    monad::small_vector<int, 2> v = {1, 2};
+    v.push_back(3);
+    check(v.size() == 3u && !v.is_inline(), "small_vector");
+
+    auto const parsed = monad::int_(std::string_view("42,"));
+    check(parsed.state().ok && parsed.value() == 42, "int_");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+// C++20 module interface for the library.  Importing it is equivalent to
+// including monad.hpp, maybe/maybe.hpp, identity.hpp, parallel.hpp,
+// validation.hpp, pipeline.hpp, memoize.hpp, parser.hpp, dataflow.hpp,
+// batch.hpp, stream.hpp, small_vector.hpp and declare_operators.hpp, but
+// the headers are parsed only once, when this interface unit is compiled.
+// Experimental: GCC 12 compiles this unit but cannot import it.
+// module_test.cpp is an importer to check a compiler with.
+
+module;
+
+#include <monad.hpp>
+#include <maybe/maybe.hpp>
+#include <identity.hpp>
+#include <parallel.hpp>
+#include <validation.hpp>
+#include <pipeline.hpp>
+#include <memoize.hpp>
+#include <parser.hpp>
+#include <dataflow.hpp>
+#include <batch.hpp>
+#include <stream.hpp>
+#include <small_vector.hpp>
+#include <declare_operators.hpp>
+
+export module monad;
+
+export namespace monad {
+
+    // monad_core.hpp
+    using ::monad::unit;
+    using ::monad::monad;
+    using ::monad::operator==;
+    using ::monad::operator!=;
+    using ::monad::operator>>=;
+    using ::monad::operator<<=;
+    using ::monad::operator>>;
+    using ::monad::operator>=;
+    using ::monad::join;
+    using ::monad::kleisli;
+    using ::monad::compose_k;
+    using ::monad::fmap;
+    using ::monad::lift;
+    using ::monad::lift_n;
+
+    // monad_traits.hpp
+    using ::monad::default_monad_traits;
+    using ::monad::monad_traits;
+
+    // algorithm.hpp
+    using ::monad::sequence;
+    using ::monad::sequence_;
+    using ::monad::sequence_as;
+    using ::monad::traverse;
+    using ::monad::traverse_as;
+    using ::monad::map;
+    using ::monad::map_;
+    using ::monad::for_;
+    using ::monad::map_unzip;
+    using ::monad::filter;
+    using ::monad::zip;
+    using ::monad::zip_;
+    using ::monad::fold;
+    using ::monad::replicate;
+    using ::monad::replicate_;
+
+    // maybe/maybe.hpp
+    using ::monad::nothing_t;
+    using ::monad::nothing;
+    using ::monad::maybe;
+
+    // identity.hpp
+    using ::monad::identity;
+
+    // parallel.hpp
+    using ::monad::sequential_policy;
+    using ::monad::parallel_policy;
+    using ::monad::seq;
+    using ::monad::par;
+    using ::monad::reduce;
+
+    // validation.hpp
+    using ::monad::validation_error;
+    using ::monad::error_arena;
+    using ::monad::validated;
+    using ::monad::valid;
+    using ::monad::invalid;
+    using ::monad::is_valid;
+    using ::monad::error_count;
+    using ::monad::errors;
+
+    // pipeline.hpp
+    using ::monad::pipeline_stage_stats;
+    using ::monad::pipeline_stats;
+    using ::monad::pipeline;
+    using ::monad::make_pipeline;
+
+    // memoize.hpp
+    using ::monad::memoize_options;
+    using ::monad::memoize_stats;
+    using ::monad::memoized;
+    using ::monad::memoize;
+
+    // parser.hpp
+    using ::monad::parsed;
+    using ::monad::parser;
+    using ::monad::make_parser;
+    using ::monad::char_;
+    using ::monad::char_if;
+    using ::monad::lit;
+    using ::monad::take_while;
+    using ::monad::pure;
+    using ::monad::int_;
+    using ::monad::eoi;
+    using ::monad::operator<<;
+    using ::monad::operator|;
+    using ::monad::many;
+    using ::monad::sep_by;
+
+    // dataflow.hpp
+    using ::monad::dataflow;
+    using ::monad::cell;
+
+    // batch.hpp
+    using ::monad::span;
+    using ::monad::batched_policy;
+    using ::monad::batched;
+
+    // stream.hpp
+    using ::monad::streamed_policy;
+    using ::monad::streamed;
+
+    // small_vector.hpp
+    using ::monad::small_vector;
+    using ::monad::small_list;
+
+    // declare_operators.hpp
+    using ::monad::lifted_operators;
+    using ::monad::operator+;
+    using ::monad::operator-;
+    using ::monad::operator*;
+    using ::monad::operator/;
+    using ::monad::operator%;
+    using ::monad::operator&;
+    using ::monad::operator^;
+    using ::monad::operator~;
+    using ::monad::operator<;
+    using ::monad::operator>;
+    using ::monad::operator<=;
+    using ::monad::operator+=;
+    using ::monad::operator-=;
+    using ::monad::operator*=;
+    using ::monad::operator/=;
+    using ::monad::operator%=;
+    using ::monad::operator&=;
+    using ::monad::operator|=;
+    using ::monad::operator^=;
+
+    namespace detail {
+        using ::monad::detail::maybe_state;
+        using ::monad::detail::parse_state;
+        using ::monad::detail::identity_state;
+        using ::monad::detail::validation_state;
+        using ::monad::detail::operator==;
+    }
+
+}
@@ -0,0 +1,258 @@
+#ifndef MONAD_CORE_HPP_INCLUDED_
+#define MONAD_CORE_HPP_INCLUDED_
+
+#include <detail/detail.hpp>
+
+#include <tuple>
+#include <utility>
+
+
+namespace monad {
+
+    /** The type with a single value.  It is the value type of the results
+        of algorithms that are evaluated only for their effect on the state,
+        such as map_().  From the Haskell type <c>()</c>. */
+    struct unit {};
+
+    constexpr bool operator== (unit, unit)
+    { return true; }
+
+    constexpr bool operator!= (unit, unit)
+    { return false; }
+
+    template <typename T, typename State>
+    class monad
+    {
+    public:
+        using this_type = monad<T, State>;
+        using value_type = T;
+        using state_type = State;
+
+        constexpr monad () :
+            value_ (),
+            state_ ()
+        {}
+
+        constexpr monad (value_type value, state_type state) :
+            value_ (std::move(value)),
+            state_ (std::move(state))
+        {}
+
+        /** Haskell's @c return: @c value, with a value-initialized state.
+            For a State whose traits set @c state_independent_of_values,
+            State{} must be the identity of combine(). */
+        constexpr monad (value_type value) :
+            value_ (std::move(value)),
+            state_ ()
+        {}
+
+        // Constructs the value in place, as with value_type{args...}.
+        template <typename ...Args>
+        constexpr monad (std::in_place_t, state_type state, Args &&... args) :
+            value_ {std::forward<Args>(args)...},
+            state_ (std::move(state))
+        {}
+
+        constexpr value_type value () const
+        { return value_; }
+
+        constexpr state_type state () const
+        { return state_; }
+
+        // The state, by reference, for loops that read it in place;
+        // state() returns a copy.
+        constexpr state_type const & state_ref () const
+        { return state_; }
+
+        /** @c Fn must accept a single parameter to which @c value_type is
+            convertible, and must return a monad with state type @c State.
+            The primary template defines bind() only for states whose
+            monad_traits set @c state_independent_of_values; the result is
+            that of @c f, with its state combined with this one.  Other
+            states must specialize monad<T, State>. */
+        template <typename Fn>
+        constexpr auto bind (Fn f) const ->
+            typename std::remove_cv<
+                decltype(f(std::declval<value_type const &>()))
+            >::type
+        {
+            using traits = monad_traits<state_type>;
+            using result_type = typename std::remove_cv<
+                decltype(f(std::declval<value_type const &>()))
+            >::type;
+            static_assert(
+                traits::state_independent_of_values,
+                "monad<T, State>::bind() requires a monad_traits<State> that "
+                "sets state_independent_of_values; otherwise, specialize "
+                "monad<T, State>."
+            );
+
+            if constexpr (traits::short_circuits) {
+                if (traits::failed(state_)) {
+                    result_type retval;
+                    retval.mutable_state() = state_;
+                    return retval;
+                }
+            }
+            result_type retval = f(value_);
+            retval.mutable_state() = traits::combine(state_, retval.state());
+            return retval;
+        }
+
+        /** TODO @c Fn must accept a single parameter to which @c value_type is
+            convertible.  @c Fn must return a value that is or is convertible
+            to @c this_type. */
+        template <typename Fn>
+        constexpr this_type fmap (Fn f)
+        {
+            return *this >>= [f](value_type x) {
+                return this_type{f(x)};
+            };
+        }
+
+        /** Requires that @c value_type be a monad with state type @c
+            State. */
+        constexpr auto join () const
+        {
+            return bind([](value_type const & inner) {
+                return inner;
+            });
+        }
+
+        constexpr value_type & mutable_value ()
+        { return value_; }
+
+        constexpr state_type & mutable_state ()
+        { return state_; }
+
+    private:
+        value_type value_;
+        state_type state_;
+    };
+
+    // operator==().
+    template <typename T, typename State>
+    constexpr bool operator== (monad<T, State> const & lhs, monad<T, State> const & rhs)
+    { return lhs.value() == rhs.value() && lhs.state() == rhs.state(); }
+
+    // operator!=().
+    template <typename T, typename State>
+    constexpr bool operator!= (monad<T, State> const & lhs, monad<T, State> const & rhs)
+    { return !(lhs == rhs); }
+
+    // operator>>=().  Fn must have a signature of the form
+    // monad<...> (T).
+    // (>>=) :: m a -> (a -> m b) -> m b
+    template <typename T, typename State, typename Fn>
+    constexpr auto operator>>= (monad<T, State> m, Fn f) -> decltype(m.bind(f))
+    { return m.bind(f); }
+
+    // operator<<=().  Fn must have a signature of the form
+    // monad<...> (T).
+    // (=<<) :: Monad m => (a -> m b) -> m a -> m b
+    template <typename T, typename State, typename Fn>
+    constexpr auto operator<<= (Fn f, monad<T, State> m) -> decltype(m.bind(f))
+    { return m.bind(f); }
+
+    // operator>>().
+    // (>>) :: m a -> m b -> m b
+    template <typename T1, typename State1, typename T2, typename State2>
+    constexpr monad<T2, State2> operator>> (monad<T1, State1> lhs, monad<T2, State2> rhs)
+    {
+        return lhs.bind([rhs](T1 const &) {
+            return rhs;
+        });
+    }
+
+    // join().
+    // join :: (Monad m) => m (m a) -> m a
+    template <typename T, typename State>
+    constexpr auto join (monad<T, State> m) -> decltype(m.join())
+    { return m.join(); }
+
+    /** The Kleisli composition of the functions @c Fns..., applied left to
+        right.  Each function must accept a single parameter to which the
+        value type of the previous function's result is convertible, and
+        must return a monad.  Use compose_k() or operator>=() to create
+        one. */
+    template <typename ...Fns>
+    class kleisli
+    {
+    public:
+        constexpr explicit kleisli (std::tuple<Fns...> fns) :
+            fns_ (fns)
+        {}
+
+        template <typename A>
+        constexpr auto operator() (A const & x) const
+        {
+            return detail::kleisli_apply<1, sizeof...(Fns)>::call(
+                fns_,
+                std::get<0>(fns_)(x)
+            );
+        }
+
+        constexpr std::tuple<Fns...> const & functions () const
+        { return fns_; }
+
+    private:
+        std::tuple<Fns...> fns_;
+    };
+
+    // compose_k().
+    // (>=>) :: Monad m => (a -> m b) -> (b -> m c) -> a -> m c
+    template <typename Fn, typename ...Fns>
+    constexpr kleisli<Fn, Fns...> compose_k (Fn f, Fns... fns)
+    { return kleisli<Fn, Fns...>{std::tuple<Fn, Fns...>{f, fns...}}; }
+
+    // operator>=().  Since C++ has no operator>=>, the left operand must be
+    // a kleisli, e.g. compose_k(f) >= g >= h.
+    // (>=>) :: Monad m => (a -> m b) -> (b -> m c) -> a -> m c
+    template <typename ...Fns, typename Fn>
+    constexpr kleisli<Fns..., Fn> operator>= (kleisli<Fns...> k, Fn f)
+    {
+        return kleisli<Fns..., Fn>{
+            std::tuple_cat(k.functions(), std::tuple<Fn>{f})
+        };
+    }
+
+    /** TODO @c Fn must accept a single parameter to which @c T is
+        convertible.  @c Fn must return a value that is or is convertible to
+        <c>monad<T, State></c>.  From the Haskell function <c>fmap :: Functor
+        f => (a -> b) -> f a -> f b</c>. */
+    template <typename T, typename State, typename Fn>
+    constexpr auto fmap (Fn f, monad<T, State> m) -> decltype(m.fmap(f))
+    { return m.fmap(f); }
+
+
+    /** TODO (TODO document the wart of needing to have a fixed return type,
+        for this and for lift_n).  @c Fn must accept a single parameter to
+        which @c T is convertible.  @c Fn must return a value that is or is
+        convertible to <c>monad<T, State></c>.  From the Haskell function
+        <c>liftM :: (Monad m) => (a -> b) -> (m a -> m b)</c>. */
+    template <typename T, typename State, typename Fn>
+    constexpr monad<T, State> lift (Fn f, monad<T, State> m)
+    {
+        return m >>= [f](T x) {
+            return monad<T, State>{f(x)};
+        };
+    }
+
+    /** N-ary version of lift(). @c Fn must accept a single@c
+        sizeof...(Monads) parameters; the types @c Monads::value_type... must
+        be convertible to the respective parameters of @c Fn.  @c Fn must
+        return a value that is or is convertible to @c ReturnMonad.  From the
+        Haskell function <c>liftM :: (Monad m) => (a -> b) -> (m a -> m
+        b)</c>. */
+    template <typename ReturnMonad, typename Fn, typename ...Monads>
+    constexpr ReturnMonad lift_n (Fn f, Monads... monads)
+    {
+        if constexpr (detail::lift_n_combinable<ReturnMonad, Monads...>::value)
+            return detail::lift_n_combined<ReturnMonad>(f, monads...);
+        else
+            return detail::lift_n_impl<ReturnMonad>::call(f, monads...);
+    }
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef MONAD_TRAITS_HPP_INCLUDED_
+#define MONAD_TRAITS_HPP_INCLUDED_
+
+#include <type_traits>
+
+
+namespace monad {
+
+    /** The properties of a monad state type that monad_traits<State>
+        describes, with their conservative defaults.  A specialization of
+        monad_traits may derive from this and override only what differs,
+        as in:
+
+        <pre>
+        template <>
+        struct monad_traits<my_state> : default_monad_traits<my_state>
+        {
+            static constexpr bool short_circuits = true;
+            static constexpr bool failed (my_state s) { return !s.ok; }
+        };
+        </pre> */
+    template <typename State>
+    struct default_monad_traits
+    {
+        /** True if a failed state ends a computation: binding a monad whose
+            state has failed() yields a monad with that state, without
+            calling the bound function.  Algorithms use this to stop at the
+            first failure instead of completing a chain of >>=. */
+        static constexpr bool short_circuits = false;
+
+        /** True if @c state indicates failure.  Algorithms stop at the
+            first state for which this is true, whether or not
+            @c short_circuits is set, so a state that does not short-circuit
+            must leave it false for every state. */
+        static constexpr bool failed (State const &)
+        { return false; }
+
+        /** True if the state of <c>m >>= f</c> depends only on the states
+            of @c m and of the monad @c f returns, and not on their values,
+            so that it is <c>combine(m.state(), f(m.value()).state())</c>,
+            and its value is that of <c>f(m.value())</c>.  A specialization
+            that sets this must also provide
+            <c>static State combine (State const &, State const &)</c>.
+            Algorithms use this to compute result states in a loop rather
+            than through a chain of >>= closures. */
+        static constexpr bool state_independent_of_values = false;
+
+        /** True if @c combine() is associative, so that the states of
+            separately-computed parts of a sequence may be combined in any
+            grouping.  parallel reduce() uses this to merge the results of
+            its chunks without >>=. */
+        static constexpr bool associative_combine = false;
+
+        /** True if a State may be moved to new storage with memcpy(). */
+        static constexpr bool trivially_relocatable =
+            std::is_trivially_copyable<State>::value;
+    };
+
+    /** The customization point through which the algorithms learn the
+        properties of a monad's state; see default_monad_traits for the
+        members a specialization must have.  Specialize it for a
+        user-defined State to give monad<T, State> the same fast paths as
+        maybe.  A State whose traits set @c state_independent_of_values may
+        also use the primary monad template directly, since its bind() is
+        defined in terms of combine(). */
+    template <typename State>
+    struct monad_traits : default_monad_traits<State>
+    {};
+
+}
+
+#endif
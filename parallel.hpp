@@ -0,0 +1,449 @@
+#ifndef PARALLEL_HPP_INCLUDED_
+#define PARALLEL_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+#include <detail/algorithm.hpp>
+
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+
+namespace monad {
+
+    /** Execution policy requesting that an algorithm run on the calling
+        thread only. */
+    struct sequential_policy {};
+
+    /** Execution policy requesting that an algorithm split its input into
+        chunks of at least @c min_chunk_size elements and process them on
+        up to @c threads threads.  A @c threads value of 0 means
+        <c>std::thread::hardware_concurrency()</c>. */
+    struct parallel_policy
+    {
+        std::size_t threads;
+        std::size_t min_chunk_size;
+    };
+
+    inline constexpr sequential_policy seq = {};
+    inline constexpr parallel_policy par = {0, 4096};
+
+    namespace detail {
+
+        // How many elements a worker processes between checks of the shared
+        // cancellation flag.  Must be a power of two.
+        inline constexpr std::size_t cancellation_check_interval = 1024;
+
+        inline std::size_t thread_count (parallel_policy policy)
+        {
+            std::size_t retval = policy.threads;
+            if (!retval)
+                retval = std::thread::hardware_concurrency();
+            return retval ? retval : 1;
+        }
+
+        // Left-folds [first, last) onto the monad m.  For states that
+        // short-circuit or whose combination does not depend on the values
+        // (see monad_traits), this is a plain loop over the values;
+        // otherwise it is the same chain of >>= that fold() uses.  If
+        // cancelled is set before the loop is done, it stops, leaving first
+        // at the next element to fold and returning the fold so far, so
+        // that the caller may resume it.
+        template <typename Monad, typename Fn, typename Iter>
+        Monad reduce_chunk (
+            Monad m,
+            Fn op,
+            Iter & first,
+            Iter last,
+            std::atomic<bool> & cancelled
+        ) {
+            using state_type = typename Monad::state_type;
+            using value_type = typename Monad::value_type;
+            using traits = monad_traits<state_type>;
+
+            if constexpr (
+                traits::short_circuits ||
+                traits::state_independent_of_values
+            ) {
+                std::size_t n = 0;
+                while (first != last) {
+                    if (traits::failed(m.state())) {
+                        cancelled.store(true, std::memory_order_relaxed);
+                        return m;
+                    }
+                    if ((++n & (cancellation_check_interval - 1)) == 0 &&
+                        cancelled.load(std::memory_order_relaxed)) {
+                        return m;
+                    }
+                    if constexpr (traits::state_independent_of_values) {
+                        state_type const state = m.state();
+                        m = op(m.value(), *first);
+                        m.mutable_state() = traits::combine(state, m.state());
+                    } else {
+                        m = op(m.value(), *first);
+                    }
+                    ++first;
+                }
+                if (traits::failed(m.state()))
+                    cancelled.store(true, std::memory_order_relaxed);
+            } else {
+                while (first != last) {
+                    auto y = *first++;
+                    m = m >>= [op, y](value_type x) {
+                        return op(x, y);
+                    };
+                }
+            }
+
+            return m;
+        }
+
+        // Combines the results of two adjacent chunks: lhs >>= \x ->
+        // rhs >>= \y -> op(x, y).
+        template <typename Monad, typename Fn>
+        Monad merge_chunks (Monad const & lhs, Monad const & rhs, Fn op)
+        {
+            using state_type = typename Monad::state_type;
+            using value_type = typename Monad::value_type;
+            using traits = monad_traits<state_type>;
+
+            if constexpr (
+                traits::state_independent_of_values &&
+                traits::associative_combine
+            ) {
+                if (traits::failed(lhs.state()))
+                    return lhs;
+                state_type const state =
+                    traits::combine(lhs.state(), rhs.state());
+                if (traits::failed(state)) {
+                    Monad retval;
+                    retval.mutable_state() = state;
+                    return retval;
+                }
+                Monad retval = op(lhs.value(), rhs.value());
+                retval.mutable_state() = traits::combine(state, retval.state());
+                return retval;
+            } else {
+                return lhs >>= [op, rhs](value_type x) {
+                    return rhs >>= [op, x](value_type y) {
+                        return op(x, y);
+                    };
+                };
+            }
+        }
+
+        // sequence_impl() over [at(0), at(size)), split into chunks that are
+        // sequenced on separate threads.  The chunks' lists are then
+        // concatenated and their states combined in order, in one pass.
+        // For short-circuiting states, the result ends at the first
+        // failure, as with sequence_impl(), though the chunks after the
+        // one that fails are still evaluated.
+        template <
+            typename Iter,
+            typename Monad,
+            typename List,
+            typename State,
+            typename Fn,
+            typename At
+        >
+        monad<List, State> parallel_sequence_impl (
+            parallel_policy policy,
+            Fn f,
+            At at,
+            std::size_t size
+        ) {
+            using traits = monad_traits<State>;
+            using chunk_result = monad<List, State>;
+
+            static_assert(
+                traits::state_independent_of_values &&
+                traits::associative_combine,
+                "Parallel map() and zip() require a monad_traits<State> that "
+                "sets state_independent_of_values and associative_combine."
+            );
+
+            std::size_t const min_chunk_size =
+                policy.min_chunk_size ? policy.min_chunk_size : 1;
+            std::size_t chunks = thread_count(policy);
+            if (size / min_chunk_size < chunks)
+                chunks = size / min_chunk_size;
+
+            if (chunks <= 1)
+                return sequence_impl<Iter, Monad, List, State>(f, at(0), at(size));
+
+            std::vector<chunk_result> results(chunks);
+            std::vector<std::exception_ptr> exceptions(chunks);
+
+            auto sequence_one = [&](std::size_t i) {
+                try {
+                    results[i] = sequence_impl<Iter, Monad, List, State>(
+                        f,
+                        at(size * i / chunks),
+                        at(size * (i + 1) / chunks)
+                    );
+                } catch (...) {
+                    exceptions[i] = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(chunks - 1);
+            for (std::size_t i = 1; i < chunks; ++i) {
+                workers.emplace_back(sequence_one, i);
+            }
+            sequence_one(0);
+            for (auto & worker : workers) {
+                worker.join();
+            }
+
+            for (auto const & e : exceptions) {
+                if (e)
+                    std::rethrow_exception(e);
+            }
+
+            chunk_result retval{List{}, results[0].state()};
+            List & values = retval.mutable_value();
+            reserve_n(values, size);
+            for (std::size_t i = 0; i < chunks; ++i) {
+                if (i)
+                    retval.mutable_state() =
+                        traits::combine(retval.state(), results[i].state());
+                List & chunk_values = results[i].mutable_value();
+                values.insert(
+                    values.end(),
+                    std::make_move_iterator(chunk_values.begin()),
+                    std::make_move_iterator(chunk_values.end())
+                );
+                if (traits::failed(retval.state()))
+                    break;
+            }
+
+            return retval;
+        }
+
+    }
+
+    /** Reduces [first, last) with @c op, starting from @c initial_value, on
+        the calling thread.  The result is the same as that of
+        <c>fold(op, initial_value, first, last)</c>, but for short-circuiting
+        states (such as maybe's) the per-element state checks are done in a
+        single loop instead of a chain of >>=. */
+    template <typename Fn, typename T, typename Iter>
+    auto reduce (
+        sequential_policy,
+        Fn op,
+        T initial_value,
+        Iter first,
+        Iter last
+    ) -> typename std::remove_cv<decltype(op(initial_value, *first))>::type
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(op(initial_value, *first))>::type;
+
+        if (first == last)
+            return monad_type{};
+
+        std::atomic<bool> cancelled{false};
+        monad_type m = op(initial_value, *first);
+        ++first;
+        return detail::reduce_chunk(m, op, first, last, cancelled);
+    }
+
+    /** Parallel tree reduction of the random access range [first, last).
+        @c op must have a signature of the form <c>monad<T, ...> (T, T)</c>
+        and must be associative as a Kleisli operation: for all @c a, @c b
+        and @c c, <c>op(a, b) >>= [&](T ab) {return op(ab, c);}</c> must
+        equal <c>op(b, c) >>= [&](T bc) {return op(a, bc);}</c>.  Under
+        that condition the result is the same as that of <c>fold(op,
+        initial_value, first, last)</c>.  The range is split into one chunk
+        per thread, each chunk is reduced independently, and the per-chunk
+        results are then combined pairwise.  For short-circuiting states, a
+        chunk that produces a failure (e.g. nothing) cancels all the
+        others; those before it are then finished on the calling thread,
+        so that the result holds the first failure, as fold()'s does.
+        Chunks other than the first are reduced starting from
+        their first element, so the monad type must be constructible from a
+        single value, as maybe is, and that element reaches @c op only as
+        its left operand; an @c op that fails on some elements must
+        therefore check both of its operands, as associativity requires. */
+    template <typename Fn, typename T, typename Iter>
+    auto reduce (
+        parallel_policy policy,
+        Fn op,
+        T initial_value,
+        Iter first,
+        Iter last
+    ) -> typename std::remove_cv<decltype(op(initial_value, *first))>::type
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(op(initial_value, *first))>::type;
+        using value_type = typename monad_type::value_type;
+
+        std::size_t const size = last - first;
+        std::size_t const min_chunk_size =
+            policy.min_chunk_size ? policy.min_chunk_size : 1;
+        std::size_t chunks = detail::thread_count(policy);
+        if (size / min_chunk_size < chunks)
+            chunks = size / min_chunk_size;
+
+        if (chunks <= 1)
+            return reduce(seq, op, initial_value, first, last);
+
+        std::atomic<bool> cancelled{false};
+        std::vector<monad_type> results(chunks);
+        std::vector<Iter> resume_at(chunks);
+        std::vector<std::exception_ptr> exceptions(chunks);
+
+        auto chunk_first = [=](std::size_t i) {
+            return first + size * i / chunks;
+        };
+
+        auto reduce_one = [&](std::size_t i) {
+            try {
+                resume_at[i] = chunk_first(i);
+                monad_type m = i ?
+                    monad_type{value_type(*resume_at[i])} :
+                    op(initial_value, *resume_at[i]);
+                ++resume_at[i];
+                results[i] = detail::reduce_chunk(
+                    m,
+                    op,
+                    resume_at[i],
+                    chunk_first(i + 1),
+                    cancelled
+                );
+            } catch (...) {
+                exceptions[i] = std::current_exception();
+                cancelled.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for (std::size_t i = 1; i < chunks; ++i) {
+            workers.emplace_back(reduce_one, i);
+        }
+        reduce_one(0);
+        for (auto & worker : workers) {
+            worker.join();
+        }
+
+        for (auto const & e : exceptions) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+
+        // A chunk's failure cancels the chunks still running, including
+        // those before it, which may hold an earlier failure.  Finish those,
+        // in order, up to the first chunk that fails; the chunks after it
+        // do not affect the result.
+        using traits = monad_traits<typename monad_type::state_type>;
+        std::atomic<bool> not_cancelled{false};
+        for (std::size_t i = 0; i < chunks; ++i) {
+            if (!traits::failed(results[i].state())) {
+                results[i] = detail::reduce_chunk(
+                    results[i],
+                    op,
+                    resume_at[i],
+                    chunk_first(i + 1),
+                    not_cancelled
+                );
+            }
+            if (traits::failed(results[i].state())) {
+                chunks = i + 1;
+                break;
+            }
+        }
+
+        for (std::size_t stride = 1; stride < chunks; stride *= 2) {
+            for (std::size_t i = 0; i + stride < chunks; i += 2 * stride) {
+                results[i] =
+                    detail::merge_chunks(results[i], results[i + stride], op);
+            }
+        }
+
+        return results[0];
+    }
+
+    /** mapM() on up to @c policy.threads threads.  The input is split into
+        chunks of at least @c policy.min_chunk_size elements, which are
+        mapped independently, and their results are concatenated in order.
+        The result is the same as that of <c>map(f, first, last)</c>,
+        provided @c f may be called concurrently.  Requires a random access
+        range, and a state whose monad_traits set
+        @c state_independent_of_values and @c associative_combine, such as
+        maybe's or validated's.  For short-circuiting states, f may be
+        called on elements after the first failure. */
+    template <
+        typename Fn,
+        typename Iter,
+        typename List = std::vector<
+            detail::list_element_t<detail::mapped_value_type_t<Fn, Iter>>
+        >
+    >
+    auto map (parallel_policy policy, Fn f, Iter first, Iter last) ->
+        monad<List, detail::state_type_t<decltype(f(*first))>>
+    {
+        using monad_type = typename std::decay<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        return detail::parallel_sequence_impl<Iter, monad_type, List, state_type>(
+            policy,
+            [f](Iter it) {return f(*it);},
+            [first](std::size_t i) {return first + i;},
+            static_cast<std::size_t>(last - first)
+        );
+    }
+
+    template <typename Fn, typename Range>
+    auto map (parallel_policy policy, Fn f, Range const & r) ->
+        decltype(map(policy, f, std::begin(r), std::end(r)))
+    { return map(policy, f, std::begin(r), std::end(r)); }
+
+    /** zipWithM() on up to @c policy.threads threads, as with the parallel
+        map().  [first2, first2 + (last1 - first1)) must be a valid random
+        access range. */
+    template <
+        typename Fn,
+        typename Iter1,
+        typename Iter2,
+        typename List = std::vector<
+            detail::list_element_t<detail::zip_value_type_t<Fn, Iter1, Iter2>>
+        >
+    >
+    auto zip (
+        parallel_policy policy,
+        Fn f,
+        Iter1 first1,
+        Iter1 last1,
+        Iter2 first2
+    ) -> monad<List, detail::state_type_t<decltype(f(*first1, *first2))>>
+    {
+        using monad_type =
+            typename std::decay<decltype(f(*first1, *first2))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using zip_iter = detail::zip_iterator<Iter1, Iter2>;
+        return detail::parallel_sequence_impl<zip_iter, monad_type, List, state_type>(
+            policy,
+            [f](zip_iter it) {return f(*it.first, *it.second);},
+            [first1, first2](std::size_t i) {
+                return zip_iter{first1 + i, first2 + i};
+            },
+            static_cast<std::size_t>(last1 - first1)
+        );
+    }
+
+    template <typename Fn, typename Range1, typename Range2>
+    auto zip (parallel_policy policy, Fn f, Range1 const & r1, Range2 const & r2) ->
+        decltype(zip(policy, f, std::begin(r1), std::end(r1), std::begin(r2)))
+    { return zip(policy, f, std::begin(r1), std::end(r1), std::begin(r2)); }
+
+    template <typename Policy, typename Fn, typename T, typename Range>
+    auto reduce (Policy policy, Fn op, T initial_value, Range const & r) ->
+        decltype(reduce(policy, op, initial_value, std::begin(r), std::end(r)))
+    { return reduce(policy, op, initial_value, std::begin(r), std::end(r)); }
+
+}
+
+#endif
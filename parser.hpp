@@ -0,0 +1,606 @@
+#ifndef PARSER_HPP_INCLUDED_
+#define PARSER_HPP_INCLUDED_
+
+#include <maybe/maybe.hpp>
+#include <monad_core.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace monad {
+
+    namespace detail {
+
+        // The state of a parse: the input that remains, and whether the
+        // parse has succeeded so far.  After a failure, rest is the input
+        // at the point of failure.  rest always refers into the original
+        // input; it is never a copy.
+        struct parse_state
+        {
+            std::string_view rest;
+            bool ok;
+        };
+
+        constexpr bool operator== (parse_state lhs, parse_state rhs)
+        { return lhs.ok == rhs.ok && lhs.rest == rhs.rest; }
+
+    }
+
+    // The state of a parse depends on the values that earlier parsers
+    // produced (through the input they consumed), so it only
+    // short-circuits.
+    template <>
+    struct monad_traits<detail::parse_state> :
+        default_monad_traits<detail::parse_state>
+    {
+        static constexpr bool short_circuits = true;
+
+        static constexpr bool failed (detail::parse_state state)
+        { return !state.ok; }
+    };
+
+    template <typename Fn>
+    class parser;
+
+    namespace detail {
+
+        template <typename T>
+        struct is_parser : std::false_type
+        {};
+
+        template <typename Fn>
+        struct is_parser<parser<Fn>> : std::true_type
+        {};
+
+    }
+
+    /** The result of running a parser: a value, and the input that
+        remains after it.  bind() passes the value to a continuation that
+        returns either a parser, which is run on the remaining input, or a
+        parsed<U>, which consumes no input. */
+    template <typename T>
+    class monad<T, detail::parse_state>
+    {
+    public:
+        using this_type = monad<T, detail::parse_state>;
+        using value_type = T;
+        using state_type = detail::parse_state;
+
+    private:
+        value_type value_;
+        state_type state_;
+
+    public:
+        constexpr monad () :
+            value_ {},
+            state_ {std::string_view(), false}
+        {}
+
+        constexpr monad (value_type value, state_type state) :
+            value_ {std::move(value)},
+            state_ (state)
+        {}
+
+        // A success that consumed no input.
+        constexpr monad (value_type value) :
+            value_ {std::move(value)},
+            state_ {std::string_view(), true}
+        {}
+
+        // A failure that consumed no input.
+        constexpr monad (nothing_t) :
+            value_ {},
+            state_ {std::string_view(), false}
+        {}
+
+        constexpr value_type const & value () const &
+        { return value_; }
+
+        constexpr value_type value () &&
+        { return std::move(value_); }
+
+        constexpr state_type state () const
+        { return state_; }
+
+        // The state, by reference, for loops that read it in place;
+        // state() returns a copy.
+        constexpr state_type const & state_ref () const
+        { return state_; }
+
+        template <typename Fn>
+        constexpr auto bind (Fn f) const
+        {
+            using next_type =
+                typename std::remove_cv<decltype(f(value_))>::type;
+            if constexpr (detail::is_parser<next_type>::value) {
+                using result_type = typename next_type::result_type;
+                if (!state_.ok)
+                    return result_type{typename result_type::value_type{}, state_};
+                return f(value_)(state_.rest);
+            } else {
+                if (!state_.ok)
+                    return next_type{typename next_type::value_type{}, state_};
+                next_type retval = f(value_);
+                retval.mutable_state().rest = state_.rest;
+                return retval;
+            }
+        }
+
+        template <typename Fn>
+        constexpr this_type fmap (Fn f)
+        {
+            return bind([f](value_type const & x) {
+                return this_type{f(x)};
+            });
+        }
+
+        constexpr value_type & mutable_value ()
+        { return value_; }
+
+        constexpr state_type & mutable_state ()
+        { return state_; }
+    };
+
+    template <typename T>
+    using parsed = monad<T, detail::parse_state>;
+
+    /** A function object that takes the input as a std::string_view and
+        returns a parsed<T>.  Parsers are combined with >>=, >>, <<, | and
+        lift_n(), and with the combinators below.  The input is only ever
+        viewed, never copied, and none of the parsers in this header
+        allocate, except those that return a std::vector. */
+    template <typename Fn>
+    class parser
+    {
+    public:
+        using result_type = typename std::remove_cv<
+            decltype(std::declval<Fn const &>()(std::string_view()))
+        >::type;
+        using value_type = typename result_type::value_type;
+
+        constexpr explicit parser (Fn f) :
+            f_ (f)
+        {}
+
+        constexpr result_type operator() (std::string_view input) const
+        { return f_(input); }
+
+    private:
+        Fn f_;
+    };
+
+    template <typename Fn>
+    constexpr parser<Fn> make_parser (Fn f)
+    { return parser<Fn>{f}; }
+
+    namespace detail {
+
+        template <typename T>
+        constexpr parsed<T> parse_failure (std::string_view at)
+        { return parsed<T>{T{}, parse_state{at, false}}; }
+
+        struct any_char_parser
+        {
+            constexpr parsed<char> operator() (std::string_view input) const
+            {
+                if (input.empty())
+                    return parse_failure<char>(input);
+                return parsed<char>{input[0], parse_state{input.substr(1), true}};
+            }
+        };
+
+        template <typename Pred>
+        struct char_if_parser
+        {
+            constexpr parsed<char> operator() (std::string_view input) const
+            {
+                if (input.empty() || !pred(input[0]))
+                    return parse_failure<char>(input);
+                return parsed<char>{input[0], parse_state{input.substr(1), true}};
+            }
+
+            Pred pred;
+        };
+
+        struct char_parser
+        {
+            constexpr parsed<char> operator() (std::string_view input) const
+            {
+                if (input.empty() || input[0] != c)
+                    return parse_failure<char>(input);
+                return parsed<char>{c, parse_state{input.substr(1), true}};
+            }
+
+            char c;
+        };
+
+        struct lit_parser
+        {
+            constexpr parsed<std::string_view>
+            operator() (std::string_view input) const
+            {
+                if (input.substr(0, s.size()) != s)
+                    return parse_failure<std::string_view>(input);
+                return parsed<std::string_view>{
+                    input.substr(0, s.size()),
+                    parse_state{input.substr(s.size()), true}
+                };
+            }
+
+            std::string_view s;
+        };
+
+        template <typename Pred>
+        struct take_while_parser
+        {
+            constexpr parsed<std::string_view>
+            operator() (std::string_view input) const
+            {
+                std::size_t n = 0;
+                while (n < input.size() && pred(input[n])) {
+                    ++n;
+                }
+                return parsed<std::string_view>{
+                    input.substr(0, n),
+                    parse_state{input.substr(n), true}
+                };
+            }
+
+            Pred pred;
+        };
+
+        template <typename Int>
+        struct int_parser
+        {
+            parsed<Int> operator() (std::string_view input) const
+            {
+                Int x = 0;
+                char const * const last = input.data() + input.size();
+                auto const result = std::from_chars(input.data(), last, x);
+                if (result.ec != std::errc())
+                    return parse_failure<Int>(input);
+                return parsed<Int>{
+                    x,
+                    parse_state{input.substr(result.ptr - input.data()), true}
+                };
+            }
+        };
+
+        struct eoi_parser
+        {
+            constexpr parsed<unit> operator() (std::string_view input) const
+            {
+                if (!input.empty())
+                    return parse_failure<unit>(input);
+                return parsed<unit>{unit{}, parse_state{input, true}};
+            }
+        };
+
+        // Applies p zero or more times, until it fails or stops consuming
+        // input, and passes each value to out.push_back().
+        template <typename Fn, typename Container>
+        struct many_parser
+        {
+            parsed<std::size_t> operator() (std::string_view input) const
+            {
+                std::size_t n = 0;
+                while (true) {
+                    auto result = p(input);
+                    if (!result.state().ok ||
+                        result.state().rest.size() == input.size()) {
+                        break;
+                    }
+                    input = result.state().rest;
+                    out->push_back(std::move(result).value());
+                    ++n;
+                }
+                return parsed<std::size_t>{n, parse_state{input, true}};
+            }
+
+            parser<Fn> p;
+            Container * out;
+        };
+
+        // Applies p zero or more times, separated by sep.  A trailing
+        // separator is not consumed.
+        template <typename Fn, typename SepFn, typename Container>
+        struct sep_by_parser
+        {
+            parsed<std::size_t> operator() (std::string_view input) const
+            {
+                auto result = p(input);
+                if (!result.state().ok)
+                    return parsed<std::size_t>{0, parse_state{input, true}};
+                input = result.state().rest;
+                out->push_back(std::move(result).value());
+                std::size_t n = 1;
+                while (true) {
+                    auto const separator = sep(input);
+                    if (!separator.state().ok)
+                        break;
+                    auto next = p(separator.state().rest);
+                    if (!next.state().ok ||
+                        next.state().rest.size() == input.size()) {
+                        break;
+                    }
+                    input = next.state().rest;
+                    out->push_back(std::move(next).value());
+                    ++n;
+                }
+                return parsed<std::size_t>{n, parse_state{input, true}};
+            }
+
+            parser<Fn> p;
+            parser<SepFn> sep;
+            Container * out;
+        };
+
+        // The element type of Range, if it is a range of parsers.
+        template <typename Range>
+        using parser_range_element_t = typename std::enable_if<
+            is_parser<
+                typename std::decay<
+                    decltype(*std::begin(std::declval<Range const &>()))
+                >::type
+            >::value,
+            typename std::decay<
+                decltype(*std::begin(std::declval<Range const &>()))
+            >::type
+        >::type;
+
+        // Applies the parsers in *parsers in order, each to the input the
+        // one before it leaves, and passes each value to out.push_back().
+        // Fails where the first of them fails.
+        template <typename Range, typename Container>
+        struct sequence_parser
+        {
+            parsed<std::size_t> operator() (std::string_view input) const
+            {
+                std::size_t n = 0;
+                for (auto const & p : *parsers) {
+                    auto result = p(input);
+                    if (!result.state().ok)
+                        return parsed<std::size_t>{n, result.state()};
+                    input = result.state().rest;
+                    out->push_back(std::move(result).value());
+                    ++n;
+                }
+                return parsed<std::size_t>{n, parse_state{input, true}};
+            }
+
+            Range const * parsers;
+            Container * out;
+        };
+
+        template <typename ReturnMonad, typename Fn>
+        constexpr ReturnMonad lift_parsers (Fn f, std::string_view input)
+        { return ReturnMonad{f(), parse_state{input, true}}; }
+
+        // Runs p, then the rest of ps... on the input p leaves, with f's
+        // leading parameter bound to p's value.
+        template <typename ReturnMonad, typename Fn, typename P, typename ...Ps>
+        constexpr ReturnMonad lift_parsers (
+            Fn f,
+            std::string_view input,
+            P const & p,
+            Ps const & ...ps
+        ) {
+            return p(input) >>= [&](typename P::value_type const & x) {
+                return make_parser([&](std::string_view rest) {
+                    auto bound = [&](auto const & ...xs) {
+                        return f(x, xs...);
+                    };
+                    return lift_parsers<ReturnMonad>(bound, rest, ps...);
+                });
+            };
+        }
+
+    }
+
+    /** Returns a parser that matches any single character. */
+    constexpr parser<detail::any_char_parser> char_ ()
+    { return parser<detail::any_char_parser>{detail::any_char_parser{}}; }
+
+    /** Returns a parser that matches the character @c c. */
+    constexpr parser<detail::char_parser> char_ (char c)
+    { return parser<detail::char_parser>{detail::char_parser{c}}; }
+
+    /** Returns a parser that matches a single character for which @c pred
+        returns true. */
+    template <typename Pred>
+    constexpr parser<detail::char_if_parser<Pred>> char_if (Pred pred)
+    {
+        return parser<detail::char_if_parser<Pred>>{
+            detail::char_if_parser<Pred>{pred}
+        };
+    }
+
+    /** Returns a parser that matches the string @c s, and whose value is
+        the matched part of the input. */
+    constexpr parser<detail::lit_parser> lit (std::string_view s)
+    { return parser<detail::lit_parser>{detail::lit_parser{s}}; }
+
+    /** Returns a parser that matches the longest, possibly empty, prefix of
+        the input whose characters all satisfy @c pred, and whose value is
+        that prefix. */
+    template <typename Pred>
+    constexpr parser<detail::take_while_parser<Pred>> take_while (Pred pred)
+    {
+        return parser<detail::take_while_parser<Pred>>{
+            detail::take_while_parser<Pred>{pred}
+        };
+    }
+
+    /** Returns a parser that consumes no input and whose value is @c x.
+        From the Haskell function <c>pure :: Applicative f => a -> f a</c>. */
+    template <typename T>
+    constexpr auto pure (T x)
+    {
+        return make_parser([x](std::string_view input) {
+            return parsed<T>{x, detail::parse_state{input, true}};
+        });
+    }
+
+    /** Matches an optionally negative decimal int. */
+    inline constexpr parser<detail::int_parser<int>> int_{
+        detail::int_parser<int>{}
+    };
+
+    /** Matches the end of the input. */
+    inline constexpr parser<detail::eoi_parser> eoi{detail::eoi_parser{}};
+
+    // operator>>=() for parsers.  The result is a parser that runs p, and
+    // then the parser f returns, on the input p leaves.  f may instead
+    // return a parsed<U>, which consumes no input.
+    template <typename Fn, typename BindFn>
+    constexpr auto operator>>= (parser<Fn> p, BindFn f)
+    {
+        return make_parser([p, f](std::string_view input) {
+            return p(input) >>= f;
+        });
+    }
+
+    // operator>>() for parsers.  Runs lhs and then rhs, and keeps rhs's
+    // value.
+    template <typename Fn1, typename Fn2>
+    constexpr auto operator>> (parser<Fn1> lhs, parser<Fn2> rhs)
+    {
+        return lhs >>= [rhs](typename parser<Fn1>::value_type const &) {
+            return rhs;
+        };
+    }
+
+    // operator<<() for parsers.  Runs lhs and then rhs, and keeps lhs's
+    // value.
+    template <typename Fn1, typename Fn2>
+    constexpr auto operator<< (parser<Fn1> lhs, parser<Fn2> rhs)
+    {
+        using value_type = typename parser<Fn1>::value_type;
+        return lhs >>= [rhs](value_type const & x) {
+            return rhs >>= [x](typename parser<Fn2>::value_type const &) {
+                return parsed<value_type>{x};
+            };
+        };
+    }
+
+    // operator|() for parsers.  Runs lhs, and if it fails, runs rhs on the
+    // same input instead.
+    template <typename Fn1, typename Fn2>
+    constexpr auto operator| (parser<Fn1> lhs, parser<Fn2> rhs)
+    {
+        static_assert(
+            std::is_same<
+                typename parser<Fn1>::value_type,
+                typename parser<Fn2>::value_type
+            >::value,
+            "Alternatives must have the same value type."
+        );
+        return make_parser([lhs, rhs](std::string_view input) {
+            auto result = lhs(input);
+            if (result.state().ok)
+                return result;
+            return rhs(input);
+        });
+    }
+
+    /** Returns a parser that applies @c p as many times as it succeeds,
+        including zero, passing each value to <c>out.push_back()</c>.  Its
+        value is the number of values appended.  Nothing is allocated
+        except by @c out, which must outlive the parser. */
+    template <typename Fn, typename Container>
+    constexpr auto many (parser<Fn> p, Container & out)
+    {
+        using impl = detail::many_parser<Fn, Container>;
+        return parser<impl>{impl{p, &out}};
+    }
+
+    /** Like many(p, out), but the values are collected in a
+        std::vector. */
+    template <typename Fn>
+    constexpr auto many (parser<Fn> p)
+    {
+        using value_type = typename parser<Fn>::value_type;
+        return make_parser([p](std::string_view input) {
+            std::vector<value_type> out;
+            auto const result = many(p, out)(input);
+            return parsed<std::vector<value_type>>{std::move(out), result.state()};
+        });
+    }
+
+    /** Returns a parser that applies @c p zero or more times, separated by
+        @c sep, passing each of p's values to <c>out.push_back()</c>.  Its
+        value is the number of values appended.  Nothing is allocated
+        except by @c out, which must outlive the parser. */
+    template <typename Fn, typename SepFn, typename Container>
+    constexpr auto sep_by (parser<Fn> p, parser<SepFn> sep, Container & out)
+    {
+        using impl = detail::sep_by_parser<Fn, SepFn, Container>;
+        return parser<impl>{impl{p, sep, &out}};
+    }
+
+    /** Like sep_by(p, sep, out), but the values are collected in a
+        std::vector. */
+    template <typename Fn, typename SepFn>
+    constexpr auto sep_by (parser<Fn> p, parser<SepFn> sep)
+    {
+        using value_type = typename parser<Fn>::value_type;
+        return make_parser([p, sep](std::string_view input) {
+            std::vector<value_type> out;
+            auto const result = sep_by(p, sep, out)(input);
+            return parsed<std::vector<value_type>>{std::move(out), result.state()};
+        });
+    }
+
+    /** sequence() for parsers.  Returns a parser that applies each of the
+        parsers in @c parsers in order, each to the input left by the one
+        before, passing each value to <c>out.push_back()</c>.  It fails
+        where the first of them fails.  Its value is the number of values
+        appended.  Nothing is allocated except by @c out; @c parsers and
+        @c out must outlive the parser. */
+    template <
+        typename Range,
+        typename Container,
+        typename = detail::parser_range_element_t<Range>
+    >
+    constexpr auto sequence (Range const & parsers, Container & out)
+    {
+        using impl = detail::sequence_parser<Range, Container>;
+        return parser<impl>{impl{&parsers, &out}};
+    }
+
+    /** Like sequence(parsers, out), but the values are collected in a
+        std::vector. */
+    template <
+        typename Range,
+        typename Parser = detail::parser_range_element_t<Range>
+    >
+    auto sequence (Range const & parsers)
+    {
+        using value_type = typename Parser::value_type;
+        return make_parser([&parsers](std::string_view input) {
+            std::vector<value_type> out;
+            auto const result = sequence(parsers, out)(input);
+            return parsed<std::vector<value_type>>{std::move(out), result.state()};
+        });
+    }
+
+    /** lift_n() for parsers.  Returns a parser that runs @c parsers... in
+        order, each on the input left by the one before, and applies @c f
+        to their values.  At least one parser is required.  @c ReturnMonad must be a parsed<T>. */
+    template <typename ReturnMonad, typename Fn, typename Fn1, typename ...Fns>
+    constexpr auto lift_n (Fn f, parser<Fn1> p, parser<Fns>... parsers)
+    {
+        return make_parser([f, p, parsers...](std::string_view input) {
+            return detail::lift_parsers<ReturnMonad>(f, input, p, parsers...);
+        });
+    }
+
+}
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef PIPELINE_HPP_INCLUDED_
+#define PIPELINE_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+#include <detail/spsc_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace monad {
+
+    /** Counters for one stage of a pipeline run. */
+    struct pipeline_stage_stats
+    {
+        /** The number of inputs the stage was applied to. */
+        std::size_t processed;
+
+        /** The number of those inputs for which the stage failed. */
+        std::size_t rejected;
+
+        /** The time spent inside the stage function. */
+        double busy_seconds;
+
+        /** Inputs per second of busy time; the rate the stage could sustain
+            if it were never starved or blocked. */
+        double throughput () const
+        { return busy_seconds ? processed / busy_seconds : 0.0; }
+    };
+
+    /** The result of pipeline::run(). */
+    struct pipeline_stats
+    {
+        std::vector<pipeline_stage_stats> stages;
+        std::size_t inputs;
+        std::size_t outputs;
+        double seconds;
+    };
+
+    namespace detail {
+
+        // queues is a tuple of the input queues of Stages...; output_type is
+        // the value type of the last stage's results.
+        template <typename T, typename ...Stages>
+        struct pipeline_types
+        {
+            using queues = std::tuple<>;
+            using output_type = T;
+        };
+
+        template <typename T, typename Stage, typename ...Stages>
+        struct pipeline_types<T, Stage, Stages...>
+        {
+            using result_type = typename std::remove_cv<
+                typename std::remove_reference<
+                    decltype(std::declval<Stage const &>()(std::declval<T &>()))
+                >::type
+            >::type;
+            using next =
+                pipeline_types<typename result_type::value_type, Stages...>;
+            using queues = decltype(std::tuple_cat(
+                std::declval<std::tuple<std::unique_ptr<spsc_queue<T>>>>(),
+                std::declval<typename next::queues>()
+            ));
+            using output_type = typename next::output_type;
+        };
+
+        // Pushes x, yielding while q is full.  Returns false if aborted is
+        // set before there is room.
+        template <typename T>
+        bool blocking_push (
+            spsc_queue<T> & q,
+            T && x,
+            std::atomic<bool> const & aborted
+        ) {
+            while (!q.try_push(std::move(x))) {
+                if (aborted.load(std::memory_order_relaxed))
+                    return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        // Pops into x, yielding while q is empty.  Returns false once q is
+        // closed and drained, or if aborted is set.
+        template <typename T>
+        bool blocking_pop (
+            spsc_queue<T> & q,
+            T & x,
+            std::atomic<bool> const & aborted
+        ) {
+            while (!q.try_pop(x)) {
+                if (q.closed())
+                    return q.try_pop(x);
+                if (aborted.load(std::memory_order_relaxed))
+                    return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+    }
+
+    /** A chain of Kleisli functions, each of which runs on its own thread.
+        The first stage must accept the input range's value type, and each
+        later stage must accept the value type of the previous stage's
+        result.  Adjacent stages are connected by bounded single-producer
+        single-consumer queues, so a slow stage blocks the stages before it
+        instead of letting memory grow.  The value types passed between
+        stages must be default constructible. */
+    template <typename ...Stages>
+    class pipeline
+    {
+    public:
+        static_assert(sizeof...(Stages) > 0, "A pipeline needs a stage.");
+
+        static constexpr std::size_t size = sizeof...(Stages);
+
+        pipeline (std::size_t queue_capacity, Stages... stages) :
+            capacity_ (queue_capacity ? queue_capacity : 1),
+            stages_ (stages...)
+        {}
+
+        /** Feeds [first, last) through the stages from the calling thread.
+            @c sink is called, from the last stage's thread, with the value
+            of each result that did not fail.  For short-circuiting states,
+            a failing result is dropped and @c reject is called, under a
+            lock, with the index of the stage and the input it failed on.
+            If a stage, @c sink or @c reject throws, the run is stopped and
+            the first exception is rethrown from run(). */
+        template <typename Iter, typename Sink, typename RejectSink>
+        pipeline_stats run (
+            Iter first,
+            Iter last,
+            Sink sink,
+            RejectSink reject
+        ) const {
+            using input_type = typename std::iterator_traits<Iter>::value_type;
+            using types = detail::pipeline_types<input_type, Stages...>;
+            using clock = std::chrono::steady_clock;
+
+            typename types::queues queues;
+            make_queues(queues, std::make_index_sequence<size>{});
+
+            std::atomic<bool> aborted{false};
+            std::mutex reject_mutex;
+            pipeline_stats retval{
+                std::vector<pipeline_stage_stats>(size, {0, 0, 0.0}),
+                0,
+                0,
+                0.0
+            };
+            std::vector<std::exception_ptr> exceptions(size + 1);
+
+            auto const start = clock::now();
+
+            std::vector<std::thread> workers;
+            workers.reserve(size);
+            start_stages(
+                workers,
+                queues,
+                sink,
+                reject,
+                reject_mutex,
+                aborted,
+                retval,
+                exceptions,
+                std::make_index_sequence<size>{}
+            );
+
+            auto & first_queue = *std::get<0>(queues);
+            try {
+                for (; first != last; ++first) {
+                    input_type x = *first;
+                    if (!detail::blocking_push(first_queue, std::move(x), aborted))
+                        break;
+                    ++retval.inputs;
+                }
+            } catch (...) {
+                exceptions[size] = std::current_exception();
+                aborted.store(true, std::memory_order_relaxed);
+            }
+            first_queue.close();
+
+            for (auto & worker : workers) {
+                worker.join();
+            }
+
+            retval.seconds =
+                std::chrono::duration<double>(clock::now() - start).count();
+
+            for (auto const & e : exceptions) {
+                if (e)
+                    std::rethrow_exception(e);
+            }
+
+            return retval;
+        }
+
+        /** Like the four-parameter run(), but failing results are simply
+            dropped. */
+        template <typename Iter, typename Sink>
+        pipeline_stats run (Iter first, Iter last, Sink sink) const
+        { return run(first, last, sink, [](std::size_t, auto const &) {}); }
+
+        template <typename Range, typename Sink, typename RejectSink>
+        pipeline_stats run (Range const & r, Sink sink, RejectSink reject) const
+        { return run(std::begin(r), std::end(r), sink, reject); }
+
+        template <typename Range, typename Sink>
+        pipeline_stats run (Range const & r, Sink sink) const
+        { return run(std::begin(r), std::end(r), sink); }
+
+    private:
+        template <typename Queues, std::size_t ...Is>
+        void make_queues (Queues & queues, std::index_sequence<Is...>) const
+        {
+            using swallow = int[];
+            (void)swallow{(
+                std::get<Is>(queues).reset(
+                    new typename std::tuple_element<
+                        Is,
+                        Queues
+                    >::type::element_type(capacity_)
+                ),
+                0
+            )...};
+        }
+
+        template <
+            typename Queues,
+            typename Sink,
+            typename RejectSink,
+            std::size_t ...Is
+        >
+        void start_stages (
+            std::vector<std::thread> & workers,
+            Queues & queues,
+            Sink & sink,
+            RejectSink & reject,
+            std::mutex & reject_mutex,
+            std::atomic<bool> & aborted,
+            pipeline_stats & stats,
+            std::vector<std::exception_ptr> & exceptions,
+            std::index_sequence<Is...>
+        ) const {
+            using swallow = int[];
+            (void)swallow{(
+                workers.emplace_back([&] {
+                    run_stage<Is>(
+                        queues,
+                        sink,
+                        reject,
+                        reject_mutex,
+                        aborted,
+                        stats,
+                        exceptions[Is]
+                    );
+                }),
+                0
+            )...};
+        }
+
+        template <
+            std::size_t I,
+            typename Queues,
+            typename Sink,
+            typename RejectSink
+        >
+        void run_stage (
+            Queues & queues,
+            Sink & sink,
+            RejectSink & reject,
+            std::mutex & reject_mutex,
+            std::atomic<bool> & aborted,
+            pipeline_stats & stats,
+            std::exception_ptr & exception
+        ) const {
+            using clock = std::chrono::steady_clock;
+
+            auto & in = *std::get<I>(queues);
+            auto & stage_stats = stats.stages[I];
+            typename std::remove_reference<decltype(in)>::type::value_type x;
+
+            try {
+                while (detail::blocking_pop(in, x, aborted)) {
+                    auto const start = clock::now();
+                    auto m = std::get<I>(stages_)(x);
+                    stage_stats.busy_seconds +=
+                        std::chrono::duration<double>(clock::now() - start).count();
+                    ++stage_stats.processed;
+
+                    using state_type = typename decltype(m)::state_type;
+                    if (monad_traits<state_type>::failed(m.state())) {
+                        ++stage_stats.rejected;
+                        std::lock_guard<std::mutex> lock(reject_mutex);
+                        reject(I, x);
+                    } else if constexpr (I + 1 < size) {
+                        auto & out = *std::get<I + 1>(queues);
+                        if (!detail::blocking_push(out, std::move(m).value(), aborted))
+                            break;
+                    } else {
+                        sink(m.value());
+                        ++stats.outputs;
+                    }
+                }
+            } catch (...) {
+                exception = std::current_exception();
+                aborted.store(true, std::memory_order_relaxed);
+            }
+
+            if constexpr (I + 1 < size)
+                std::get<I + 1>(queues)->close();
+        }
+
+        std::size_t capacity_;
+        std::tuple<Stages...> stages_;
+    };
+
+    /** Returns a pipeline of @c stages whose queues each hold up to
+        @c queue_capacity values (rounded up to a power of two). */
+    template <typename ...Stages>
+    pipeline<Stages...> make_pipeline (std::size_t queue_capacity, Stages... stages)
+    { return pipeline<Stages...>(queue_capacity, stages...); }
+
+    /** Returns a pipeline with one stage per function in @c k. */
+    template <typename ...Fns>
+    pipeline<Fns...> make_pipeline (std::size_t queue_capacity, kleisli<Fns...> const & k)
+    {
+        return std::apply([queue_capacity](Fns const & ...fns) {
+            return pipeline<Fns...>(queue_capacity, fns...);
+        }, k.functions());
+    }
+
+}
+
+#endif
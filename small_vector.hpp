@@ -0,0 +1,330 @@
+#ifndef SMALL_VECTOR_HPP_INCLUDED_
+#define SMALL_VECTOR_HPP_INCLUDED_
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+namespace monad {
+
+    /** A sequence container with storage for @c N elements inside the
+        object itself; it allocates only when it grows beyond that.  It
+        provides the parts of the std::vector interface that the algorithms
+        use for their results (push_back(), insert(), reserve(), iteration,
+        etc.), so
+        it may be used as their @c List type.  Iterators and references are
+        invalidated by any operation that moves the elements, which
+        includes moving a small_vector that has not allocated. */
+    template <typename T, std::size_t N>
+    class small_vector
+    {
+        static_assert(0 < N, "small_vector requires inline storage.");
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T &;
+        using const_reference = T const &;
+        using pointer = T *;
+        using const_pointer = T const *;
+        using iterator = T *;
+        using const_iterator = T const *;
+
+        small_vector () noexcept :
+            data_ (inline_data()),
+            size_ (0),
+            capacity_ (N)
+        {}
+
+        small_vector (std::initializer_list<T> il) :
+            small_vector ()
+        {
+            reserve(il.size());
+            std::uninitialized_copy(il.begin(), il.end(), data_);
+            size_ = il.size();
+        }
+
+        small_vector (small_vector const & other) :
+            small_vector ()
+        {
+            reserve(other.size_);
+            std::uninitialized_copy(other.begin(), other.end(), data_);
+            size_ = other.size_;
+        }
+
+        small_vector (small_vector && other)
+            noexcept(std::is_nothrow_move_constructible<T>::value) :
+            small_vector ()
+        { take(other); }
+
+        small_vector & operator= (small_vector const & other)
+        {
+            if (this != &other) {
+                clear();
+                reserve(other.size_);
+                std::uninitialized_copy(other.begin(), other.end(), data_);
+                size_ = other.size_;
+            }
+            return *this;
+        }
+
+        small_vector & operator= (small_vector && other)
+            noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if (this != &other) {
+                clear();
+                deallocate();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~small_vector ()
+        {
+            clear();
+            deallocate();
+        }
+
+        size_type size () const noexcept
+        { return size_; }
+
+        size_type capacity () const noexcept
+        { return capacity_; }
+
+        bool empty () const noexcept
+        { return !size_; }
+
+        size_type max_size () const noexcept
+        {
+            return
+                static_cast<size_type>(std::numeric_limits<difference_type>::max()) /
+                sizeof(T);
+        }
+
+        T * data () noexcept
+        { return data_; }
+
+        T const * data () const noexcept
+        { return data_; }
+
+        iterator begin () noexcept
+        { return data_; }
+
+        iterator end () noexcept
+        { return data_ + size_; }
+
+        const_iterator begin () const noexcept
+        { return data_; }
+
+        const_iterator end () const noexcept
+        { return data_ + size_; }
+
+        T & operator[] (size_type i)
+        { return data_[i]; }
+
+        T const & operator[] (size_type i) const
+        { return data_[i]; }
+
+        T & front ()
+        { return data_[0]; }
+
+        T const & front () const
+        { return data_[0]; }
+
+        T & back ()
+        { return data_[size_ - 1]; }
+
+        T const & back () const
+        { return data_[size_ - 1]; }
+
+        /** True if the elements are in the inline storage. */
+        bool is_inline () const noexcept
+        { return data_ == inline_data(); }
+
+        void reserve (size_type n)
+        {
+            if (n <= capacity_)
+                return;
+            if (max_size() < n)
+                throw std::length_error("small_vector::reserve");
+            T * const new_data = allocate(n);
+            try {
+                std::uninitialized_move(data_, data_ + size_, new_data);
+            } catch (...) {
+                free(new_data);
+                throw;
+            }
+            std::destroy(data_, data_ + size_);
+            deallocate();
+            data_ = new_data;
+            capacity_ = n;
+        }
+
+        void push_back (T const & x)
+        { emplace_back(x); }
+
+        void push_back (T && x)
+        { emplace_back(std::move(x)); }
+
+        template <typename ...Args>
+        T & emplace_back (Args &&... args)
+        {
+            if (size_ == capacity_) {
+                // x may refer to an element, so it is constructed before
+                // the elements move.
+                T x(std::forward<Args>(args)...);
+                grow(1);
+                ::new (static_cast<void *>(data_ + size_)) T(std::move(x));
+            } else {
+                ::new (static_cast<void *>(data_ + size_)) T(std::forward<Args>(args)...);
+            }
+            return data_[size_++];
+        }
+
+        /** Inserts copies of [first, last) before @c pos, which must not
+            be iterators into *this. */
+        template <
+            typename Iter,
+            typename = typename std::iterator_traits<Iter>::iterator_category
+        >
+        iterator insert (const_iterator pos, Iter first, Iter last)
+        {
+            size_type const offset = pos - data_;
+            size_type const old_size = size_;
+            if constexpr (
+                std::is_base_of<
+                    std::forward_iterator_tag,
+                    typename std::iterator_traits<Iter>::iterator_category
+                >::value
+            ) {
+                size_type const n = std::distance(first, last);
+                if (capacity_ - size_ < n)
+                    grow(n);
+                std::uninitialized_copy(first, last, data_ + size_);
+                size_ += n;
+            } else {
+                for (; first != last; ++first) {
+                    emplace_back(*first);
+                }
+            }
+            std::rotate(data_ + offset, data_ + old_size, data_ + size_);
+            return data_ + offset;
+        }
+
+        void pop_back ()
+        {
+            --size_;
+            data_[size_].~T();
+        }
+
+        void clear () noexcept
+        {
+            std::destroy(data_, data_ + size_);
+            size_ = 0;
+        }
+
+    private:
+        T * inline_data () noexcept
+        { return reinterpret_cast<T *>(storage_); }
+
+        T const * inline_data () const noexcept
+        { return reinterpret_cast<T const *>(storage_); }
+
+        // Storage for n elements, aligned for T even if it is
+        // over-aligned.
+        static T * allocate (size_type n)
+        {
+            if constexpr (__STDCPP_DEFAULT_NEW_ALIGNMENT__ < alignof(T)) {
+                return static_cast<T *>(
+                    ::operator new(n * sizeof(T), std::align_val_t(alignof(T)))
+                );
+            } else {
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            }
+        }
+
+        static void free (T * p) noexcept
+        {
+            if constexpr (__STDCPP_DEFAULT_NEW_ALIGNMENT__ < alignof(T))
+                ::operator delete(p, std::align_val_t(alignof(T)));
+            else
+                ::operator delete(p);
+        }
+
+        // Makes room for at least n more elements, at least doubling the
+        // capacity.
+        void grow (size_type n)
+        {
+            if (max_size() - size_ < n)
+                throw std::length_error("small_vector: too many elements");
+            size_type new_capacity =
+                capacity_ < max_size() / 2 ? 2 * capacity_ : max_size();
+            if (new_capacity < size_ + n)
+                new_capacity = size_ + n;
+            reserve(new_capacity);
+        }
+
+        void deallocate () noexcept
+        {
+            if (!is_inline())
+                free(data_);
+            data_ = inline_data();
+            capacity_ = N;
+        }
+
+        // Requires that *this be empty and inline.
+        void take (small_vector & other)
+        {
+            if (other.is_inline()) {
+                std::uninitialized_move(other.begin(), other.end(), data_);
+                size_ = other.size_;
+                other.clear();
+            } else {
+                data_ = other.data_;
+                size_ = other.size_;
+                capacity_ = other.capacity_;
+                other.data_ = other.inline_data();
+                other.size_ = 0;
+                other.capacity_ = N;
+            }
+        }
+
+        alignas(T) unsigned char storage_[N * sizeof(T)];
+        T * data_;
+        size_type size_;
+        size_type capacity_;
+    };
+
+    template <typename T, std::size_t N>
+    bool operator== (small_vector<T, N> const & lhs, small_vector<T, N> const & rhs)
+    {
+        return
+            lhs.size() == rhs.size() &&
+            std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    template <typename T, std::size_t N>
+    bool operator!= (small_vector<T, N> const & lhs, small_vector<T, N> const & rhs)
+    { return !(lhs == rhs); }
+
+    /** Selects small_vector<T, N> as the List type of an algorithm's
+        result, as in <c>map<small_list<8>>(f, r)</c>. */
+    template <std::size_t N>
+    struct small_list
+    {
+        template <typename T>
+        using list = small_vector<T, N>;
+    };
+
+}
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef STREAM_HPP_INCLUDED_
+#define STREAM_HPP_INCLUDED_
+
+#include <batch.hpp>
+#include <detail/algorithm.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace monad {
+
+    /** Execution policy requesting that an algorithm read its input once,
+        front to back, and pass its results to a sink in chunks of at most
+        @c chunk_size elements instead of collecting them.  The algorithm
+        holds at most one chunk at a time, so its memory use does not depend
+        on the length of the input, which may come from a single-pass
+        iterator such as std::istream_iterator, and may end at a sentinel of
+        a different type than the iterator.  A @c chunk_size of 0 means as
+        many elements as fit in 16KB. */
+    struct streamed_policy
+    {
+        std::size_t chunk_size;
+    };
+
+    inline constexpr streamed_policy streamed = {0};
+
+    namespace detail {
+
+        template <typename T>
+        std::size_t chunk_size (streamed_policy policy)
+        { return chunk_size<T>(batched_policy{policy.chunk_size}); }
+
+        // A buffer of up to one chunk of results, passed to a sink as a
+        // span each time it fills, and reused.
+        template <typename T, typename Sink>
+        class chunk_buffer
+        {
+        public:
+            chunk_buffer (std::size_t size, Sink & sink) :
+                size_ (size),
+                sink_ (sink)
+            { values_.reserve(size); }
+
+            template <typename U>
+            void push_back (U && x)
+            {
+                values_.push_back(std::forward<U>(x));
+                if (values_.size() == size_)
+                    flush();
+            }
+
+            void flush ()
+            {
+                if (values_.empty())
+                    return;
+                sink_(span<T>(values_.data(), values_.size()));
+                values_.clear();
+            }
+
+        private:
+            std::vector<T> values_;
+            std::size_t size_;
+            Sink & sink_;
+        };
+
+        // Like sequence_impl(), but the values are passed to sink in chunks
+        // as they are produced, rather than collected.  Only the state of
+        // the result is computed.  As with sequence(), the values before
+        // the first failure are kept, and so are passed to sink.
+        template <
+            typename Monad,
+            typename State,
+            typename Fn,
+            typename Iter,
+            typename Sentinel,
+            typename Sink
+        >
+        monad<unit, State> stream_sequence_impl (
+            streamed_policy policy,
+            Fn f,
+            Iter first,
+            Sentinel last,
+            Sink & sink
+        ) {
+            using traits = monad_traits<State>;
+            using value_type = list_element_t<typename Monad::value_type>;
+
+            if (first == last)
+                return monad<unit, State>{};
+
+            chunk_buffer<value_type, Sink> chunk(
+                chunk_size<value_type>(policy),
+                sink
+            );
+
+            Monad prev = f(*first);
+            ++first;
+
+            if (traits::failed(prev.state()))
+                return monad<unit, State>{unit{}, prev.state()};
+
+            if constexpr (traits::state_independent_of_values) {
+                State state = prev.state();
+                chunk.push_back(std::move(prev).value());
+                while (first != last) {
+                    Monad m = f(*first);
+                    ++first;
+                    state = traits::combine(state, m.state());
+                    if (traits::failed(state))
+                        break;
+                    chunk.push_back(std::move(m).value());
+                }
+                chunk.flush();
+                return monad<unit, State>{unit{}, state};
+            } else {
+                chunk.push_back(prev.value());
+                while (first != last) {
+                    Monad m = f(*first);
+                    ++first;
+                    prev = prev >>= [=](typename Monad::value_type const &) {
+                        return m;
+                    };
+                    if (traits::failed(prev.state()))
+                        break;
+                    chunk.push_back(m.value());
+                }
+                chunk.flush();
+                return monad<unit, State>{unit{}, prev.state()};
+            }
+        }
+
+    }
+
+    // sequence() over a single-pass input.  The values are passed to sink,
+    // which must have a signature of the form void (span<T>), in chunks of
+    // at most policy.chunk_size; sink may move from the elements of each
+    // span.  The result has the same state as that of sequence(first,
+    // last).  As with sequence(), the values before the first failure are
+    // kept, so a sink that must not act on the values of a failed sequence
+    // should defer doing so until the result is known.
+    template <
+        typename Iter,
+        typename Sentinel,
+        typename Sink,
+        typename Monad = typename std::iterator_traits<Iter>::value_type,
+        typename State = typename Monad::state_type
+    >
+    monad<unit, State> sequence (
+        streamed_policy policy,
+        Iter first,
+        Sentinel last,
+        Sink sink
+    ) {
+        return detail::stream_sequence_impl<Monad, State>(
+            policy,
+            [](Monad const & m) -> Monad const & {return m;},
+            std::move(first),
+            std::move(last),
+            sink
+        );
+    }
+
+    // Ranges are taken by forwarding reference, since the begin() of a
+    // single-pass range (e.g. a generator) is often not const.
+    template <typename Range, typename Sink>
+    auto sequence (streamed_policy policy, Range && r, Sink sink) ->
+        decltype(sequence(policy, std::begin(r), std::end(r), sink))
+    { return sequence(policy, std::begin(r), std::end(r), sink); }
+
+    // map() over a single-pass input.  Fn must have a signature of the
+    // form monad<...> (typename Iter::value_type), and sink must accept
+    // span<T>, where T is the value type of the monads Fn returns.  The
+    // values are passed to sink as described for the streamed sequence().
+    template <typename Fn, typename Iter, typename Sentinel, typename Sink>
+    auto map (
+        streamed_policy policy,
+        Fn f,
+        Iter first,
+        Sentinel last,
+        Sink sink
+    ) -> monad<unit, detail::state_type_t<decltype(f(*first))>>
+    {
+        using monad_type = typename std::remove_cv<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        return detail::stream_sequence_impl<monad_type, state_type>(
+            policy,
+            f,
+            std::move(first),
+            std::move(last),
+            sink
+        );
+    }
+
+    template <typename Fn, typename Range, typename Sink>
+    auto map (streamed_policy policy, Fn f, Range && r, Sink sink) ->
+        decltype(map(policy, f, std::begin(r), std::end(r), sink))
+    { return map(policy, f, std::begin(r), std::end(r), sink); }
+
+    // filter() over a single-pass input.  Predicate Fn must have a
+    // signature of the form monad<bool, ...> (typename Iter::value_type),
+    // and sink must accept span<typename Iter::value_type>.  Each element
+    // is read once, and copied only if it is kept.
+    template <typename Fn, typename Iter, typename Sentinel, typename Sink>
+    auto filter (
+        streamed_policy policy,
+        Fn f,
+        Iter first,
+        Sentinel last,
+        Sink sink
+    ) -> monad<unit, detail::state_type_t<decltype(f(*first))>>
+    {
+        using monad_type = typename std::remove_cv<decltype(f(*first))>::type;
+        using state_type = detail::state_type_t<monad_type>;
+        using value_type = typename std::remove_cv<
+            typename std::remove_reference<decltype(*first)>::type
+        >::type;
+        using traits = monad_traits<state_type>;
+
+        if (first == last)
+            return monad<unit, state_type>{};
+
+        detail::chunk_buffer<value_type, Sink> chunk(
+            detail::chunk_size<value_type>(policy),
+            sink
+        );
+
+        // Each element is read through a single dereference, since an
+        // input iterator need not give the same element twice.
+        auto first_result = [&] {
+            auto && x = *first;
+            monad_type m = f(x);
+            if (!traits::failed(m.state()) && m.value())
+                chunk.push_back(std::forward<decltype(x)>(x));
+            return m;
+        };
+
+        if constexpr (traits::state_independent_of_values) {
+            state_type state = first_result().state();
+            while (!traits::failed(state) && ++first != last) {
+                auto && x = *first;
+                monad_type const m = f(x);
+                state = traits::combine(state, m.state());
+                if (!traits::failed(state) && m.value())
+                    chunk.push_back(std::forward<decltype(x)>(x));
+            }
+            chunk.flush();
+            return monad<unit, state_type>{unit{}, state};
+        } else {
+            monad_type prev = first_result();
+            while (!traits::failed(prev.state()) && ++first != last) {
+                auto && x = *first;
+                monad_type m = f(x);
+                prev = prev >>= [=](bool) {return m;};
+                if (!traits::failed(prev.state()) && m.value())
+                    chunk.push_back(std::forward<decltype(x)>(x));
+            }
+            chunk.flush();
+            return monad<unit, state_type>{unit{}, prev.state()};
+        }
+    }
+
+    template <typename Fn, typename Range, typename Sink>
+    auto filter (streamed_policy policy, Fn f, Range && r, Sink sink) ->
+        decltype(filter(policy, f, std::begin(r), std::end(r), sink))
+    { return filter(policy, f, std::begin(r), std::end(r), sink); }
+
+    // fold() over a single-pass input.  Fn must have a signature of the
+    // form monad<T, ...> (T, typename Iter::value_type).  Only the
+    // accumulator is kept; no chunks are needed, so policy.chunk_size is
+    // ignored.
+    template <typename Fn, typename T, typename Iter, typename Sentinel>
+    auto fold (
+        streamed_policy,
+        Fn f,
+        T initial_value,
+        Iter first,
+        Sentinel last
+    ) -> typename std::remove_cv<decltype(f(initial_value, *first))>::type
+    {
+        using monad_type =
+            typename std::remove_cv<decltype(f(initial_value, *first))>::type;
+        using value_type = typename monad_type::value_type;
+        using state_type = typename monad_type::state_type;
+        using traits = monad_traits<state_type>;
+
+        if (first == last)
+            return monad_type{};
+
+        monad_type retval = f(std::move(initial_value), *first);
+        ++first;
+
+        if constexpr (traits::state_independent_of_values) {
+            while (first != last && !traits::failed(retval.state())) {
+                state_type const state = retval.state();
+                retval = f(std::move(retval).value(), *first);
+                ++first;
+                retval.mutable_state() = traits::combine(state, retval.state());
+            }
+        } else {
+            while (first != last) {
+                auto && y = *first;
+                retval = retval >>= [&f, &y](value_type const & x) {
+                    return f(x, y);
+                };
+                ++first;
+            }
+        }
+
+        return retval;
+    }
+
+    template <typename Fn, typename T, typename Range>
+    auto fold (streamed_policy policy, Fn f, T initial_value, Range && r) ->
+        decltype(fold(policy, f, initial_value, std::begin(r), std::end(r)))
+    { return fold(policy, f, std::move(initial_value), std::begin(r), std::end(r)); }
+
+}
+
+#endif
@@ -1,14 +1,65 @@
 #include "maybe/maybe.hpp"
+#include "algorithm.hpp"
 #include "maybe/io.hpp"
 #include "declare_operators.hpp"
-
+#include "parallel.hpp"
+#include "pipeline.hpp"
+#include "memoize.hpp"
+#include "parser.hpp"
+#include "dataflow.hpp"
+#include "batch.hpp"
+#include "small_vector.hpp"
+#include "identity.hpp"
+#include "stream.hpp"
+#include "validation.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#if __cplusplus > 201703L
+#include <span>
+#endif
 
 #define BOOST_TEST_MODULE Monad
 
 #include <cstdio>
 #include <boost/test/included/unit_test.hpp>
 
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+    // The number of calls to the global operator new, for tests that
+    // check that an operation does not allocate.
+    std::atomic<std::size_t> allocations{0};
+
+}
+
+void * operator new (std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void * p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete (void * p) noexcept
+{ std::free(p); }
+
+void operator delete (void * p, std::size_t) noexcept
+{ std::free(p); }
+
 
 BOOST_AUTO_TEST_CASE(maybe_regularity)
 {
@@ -48,11 +99,111 @@ BOOST_AUTO_TEST_CASE(maybe_regularity)
     // mutation does not affect copies
     assigned_from_1 = nothing;
     BOOST_CHECK(_1 != nothing);
+
+    // state_ref() refers to the state that state() copies
+    monad::maybe<int> const & const_1 = _1;
+    BOOST_CHECK(const_1.state_ref().nonempty_);
+    BOOST_CHECK(!nothing_with_1.state_ref().nonempty_);
+    _1.mutable_state().nonempty_ = false;
+    BOOST_CHECK(!const_1.state_ref().nonempty_);
 }
 
 
-// TODO: Test separately.
-// MONAD_TEMPLATE_BINARY_OP(+, monad::maybe, 1);
+BOOST_AUTO_TEST_CASE(lifted_operators)
+{
+    using monad::maybe;
+
+    maybe<int> const _7 = 7;
+    maybe<int> const _2 = 2;
+    maybe<int> const nothing = monad::nothing;
+
+    BOOST_CHECK_EQUAL(_7 + _2, maybe<int>{9});
+    BOOST_CHECK_EQUAL(_7 - _2, maybe<int>{5});
+    BOOST_CHECK_EQUAL(_7 * _2, maybe<int>{14});
+    BOOST_CHECK_EQUAL(_7 / _2, maybe<int>{3});
+    BOOST_CHECK_EQUAL(_7 % _2, maybe<int>{1});
+    BOOST_CHECK_EQUAL(_7 & _2, maybe<int>{2});
+    BOOST_CHECK_EQUAL(_7 | _2, maybe<int>{7});
+    BOOST_CHECK_EQUAL(_7 ^ _2, maybe<int>{5});
+    BOOST_CHECK_EQUAL(-_7, maybe<int>{-7});
+    BOOST_CHECK_EQUAL(+_7, maybe<int>{7});
+    BOOST_CHECK_EQUAL(~_7, maybe<int>{~7});
+
+    BOOST_CHECK_EQUAL(_7 < _2, maybe<bool>{false});
+    BOOST_CHECK_EQUAL(_7 > _2, maybe<bool>{true});
+    BOOST_CHECK_EQUAL(_7 <= _7, maybe<bool>{true});
+    BOOST_CHECK_EQUAL(_2 >= _7, maybe<bool>{false});
+    BOOST_CHECK_EQUAL(maybe<int>{1} + maybe<double>{0.5}, maybe<double>{1.5});
+
+    BOOST_CHECK_EQUAL(_7 + nothing, monad::nothing);
+    BOOST_CHECK_EQUAL(nothing * _7, monad::nothing);
+    BOOST_CHECK_EQUAL(-nothing, monad::nothing);
+    BOOST_CHECK_EQUAL(nothing < _7, monad::nothing);
+
+    static_assert((maybe<int>{3} * maybe<int>{4}).value() == 12, "");
+
+    {
+        maybe<int> x = 7;
+        x += _2;
+        BOOST_CHECK_EQUAL(x, maybe<int>{9});
+        x *= _2;
+        BOOST_CHECK_EQUAL(x, maybe<int>{18});
+        x ^= maybe<int>{1};
+        BOOST_CHECK_EQUAL(x, maybe<int>{19});
+        x -= nothing;
+        BOOST_CHECK_EQUAL(x, monad::nothing);
+        x += _2;
+        BOOST_CHECK_EQUAL(x, monad::nothing);
+    }
+
+    // Compound assignment mutates the payload in place, and an rvalue
+    // operand's payload is reused.
+    {
+        std::string s;
+        s.reserve(64);
+        s = "abc";
+        char const * const data = s.data();
+
+        maybe<std::string> m{std::move(s)};
+        BOOST_CHECK_EQUAL(m.value().data(), data);
+        m += maybe<std::string>{std::string("def")};
+        BOOST_CHECK_EQUAL(m.value(), "abcdef");
+        BOOST_CHECK_EQUAL(m.value().data(), data);
+
+        maybe<std::string> const sum = std::move(m) + maybe<std::string>{std::string("g")};
+        BOOST_CHECK_EQUAL(sum.value(), "abcdefg");
+        BOOST_CHECK_EQUAL(sum.value().data(), data);
+    }
+
+    // Element-wise over vectors.
+    {
+        std::vector<maybe<int>> const lhs = {maybe<int>{6}, nothing, maybe<int>{9}, maybe<int>{1}};
+        std::vector<maybe<int>> const rhs = {maybe<int>{3}, maybe<int>{1}, nothing, maybe<int>{0}};
+        std::vector<maybe<int>> const quotients = lhs / std::vector<maybe<int>>{
+            maybe<int>{3}, maybe<int>{0}, nothing, maybe<int>{1}
+        };
+        BOOST_CHECK_EQUAL(quotients.size(), 4u);
+        BOOST_CHECK_EQUAL(quotients[0], maybe<int>{2});
+        BOOST_CHECK_EQUAL(quotients[1], monad::nothing);
+        BOOST_CHECK_EQUAL(quotients[3], maybe<int>{1});
+
+        std::vector<maybe<int>> const differences = lhs - rhs;
+        BOOST_CHECK_EQUAL(differences[0], maybe<int>{3});
+        BOOST_CHECK_EQUAL(differences[1], monad::nothing);
+        BOOST_CHECK_EQUAL(differences[2], monad::nothing);
+        BOOST_CHECK_EQUAL(differences[3], maybe<int>{1});
+
+        std::vector<maybe<std::string>> const strings = {
+            maybe<std::string>{std::string("a")},
+            maybe<std::string>{monad::nothing}
+        };
+        std::vector<maybe<std::string>> const doubled = strings + strings;
+        BOOST_CHECK_EQUAL(doubled[0], maybe<std::string>{std::string("aa")});
+        BOOST_CHECK_EQUAL(doubled[1], monad::nothing);
+
+        BOOST_CHECK_THROW(lhs + std::vector<maybe<int>>{}, std::invalid_argument);
+    }
+}
 
 template <typename T>
 T add3 (T l, T m, T r)
@@ -312,3 +463,1753 @@ BOOST_AUTO_TEST_CASE(maybe)
     BOOST_CHECK_EQUAL((monad::zip(zip_sum_nonzero, set_213, set_neg_111_float)), monad::nothing);
     BOOST_CHECK_EQUAL((monad::zip(zip_sum_nonzero, set_231, set_neg_111_float)), monad::nothing);
 }
+
+
+constexpr monad::maybe<int> checked_scale (int x)
+{ return x ? monad::maybe<int>{1000 / x} : monad::nothing; }
+
+constexpr monad::maybe<int> checked_sum (int lhs, int rhs)
+{ return 0 <= rhs ? monad::maybe<int>{lhs + rhs} : monad::nothing; }
+
+constexpr int constexpr_add3 (int l, int m, int r)
+{ return l + m + r; }
+
+BOOST_AUTO_TEST_CASE(maybe_constexpr)
+{
+    constexpr monad::maybe<int> m_nothing = monad::nothing;
+    constexpr monad::maybe<int> m_3 = 3;
+
+    static_assert(m_nothing == monad::nothing, "");
+    static_assert(m_3 != monad::nothing, "");
+    static_assert(m_3.value() == 3, "");
+
+
+    // operator>>=, fmap and lift_n
+
+    static_assert((m_3 >>= checked_scale) == monad::maybe<int>{333}, "");
+    static_assert((m_nothing >>= checked_scale) == monad::nothing, "");
+    static_assert(
+        monad::lift_n<monad::maybe<int>>(constexpr_add3, m_3, m_3, m_3) ==
+        monad::maybe<int>{9},
+        ""
+    );
+    static_assert(
+        monad::lift_n<monad::maybe<int>>(constexpr_add3, m_3, m_nothing, m_3) ==
+        monad::nothing,
+        ""
+    );
+
+
+    // lookup tables over std::array
+
+    constexpr std::array<int, 4> inputs = {{1, 2, 4, 5}};
+    constexpr std::array<int, 4> bad_inputs = {{1, 2, 0, 5}};
+
+    constexpr auto table = monad::map(checked_scale, inputs);
+    static_assert(table != monad::nothing, "");
+    static_assert(table.value()[0] == 1000, "");
+    static_assert(table.value()[1] == 500, "");
+    static_assert(table.value()[2] == 250, "");
+    static_assert(table.value()[3] == 200, "");
+
+    static_assert(monad::map(checked_scale, bad_inputs) == monad::nothing, "");
+
+    constexpr std::array<monad::maybe<int>, 3> good_maybes = {{1, 2, 3}};
+    constexpr std::array<monad::maybe<int>, 3> bad_maybes =
+        {{1, monad::nothing, 3}};
+    static_assert(monad::sequence(good_maybes).value()[2] == 3, "");
+    static_assert(monad::sequence(bad_maybes) == monad::nothing, "");
+
+    static_assert(
+        monad::fold(checked_sum, 0, inputs) == monad::maybe<int>{12},
+        ""
+    );
+
+    constexpr std::array<int, 3> negative_inputs = {{1, -2, 3}};
+    static_assert(
+        monad::fold(checked_sum, 0, negative_inputs) == monad::nothing,
+        ""
+    );
+
+    BOOST_CHECK_EQUAL(table, (monad::maybe<std::array<int, 4>>{{{1000, 500, 250, 200}}}));
+}
+
+
+BOOST_AUTO_TEST_CASE(reduce)
+{
+    // Associative as a Kleisli operation: the result is nothing if any
+    // operand is negative or the sum exceeds limit, however the operands
+    // are grouped.
+    long const limit = 100000000;
+    auto checked_sum = [limit](long lhs, long rhs) {
+        return 0 <= lhs && 0 <= rhs && lhs + rhs <= limit ?
+            monad::maybe<long>{lhs + rhs} :
+            monad::nothing;
+    };
+
+    std::vector<long> empty_set;
+    std::vector<long> values(10000);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = i;
+    }
+    std::vector<long> bad_values = values;
+    bad_values[7777] = -1;
+
+    monad::parallel_policy four_threads = {4, 16};
+
+    BOOST_CHECK_EQUAL(monad::reduce(monad::seq, checked_sum, 0, empty_set), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::reduce(four_threads, checked_sum, 0, empty_set), monad::nothing);
+
+    BOOST_CHECK_EQUAL(monad::reduce(monad::seq, checked_sum, 5, values),
+                      monad::fold(checked_sum, 5, values));
+    BOOST_CHECK_EQUAL(monad::reduce(four_threads, checked_sum, 5, values),
+                      monad::fold(checked_sum, 5, values));
+    BOOST_CHECK_EQUAL(monad::reduce(monad::par, checked_sum, 5, values),
+                      monad::fold(checked_sum, 5, values));
+
+    BOOST_CHECK_EQUAL(monad::reduce(monad::seq, checked_sum, 0, bad_values), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::reduce(four_threads, checked_sum, 0, bad_values), monad::nothing);
+
+    // Failures at the first and last element of each of four_threads's
+    // chunks, which start at values.size() * i / 4.
+    for (std::size_t i = 0; i < 4; ++i) {
+        for (std::size_t index : {values.size() * i / 4, values.size() * (i + 1) / 4 - 1}) {
+            bad_values = values;
+            bad_values[index] = -1;
+            BOOST_CHECK_EQUAL(monad::fold(checked_sum, 0, bad_values), monad::nothing);
+            BOOST_CHECK_EQUAL(monad::reduce(four_threads, checked_sum, 0, bad_values), monad::nothing);
+        }
+    }
+
+    // A failure that depends on the grouping of the whole range.
+    bad_values = values;
+    bad_values[5000] = limit - 1000;
+    BOOST_CHECK_EQUAL(monad::fold(checked_sum, 0, bad_values), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::reduce(four_threads, checked_sum, 0, bad_values), monad::nothing);
+
+    // More threads than elements.
+    std::vector<long> few_values = {1, 2, 3};
+    monad::parallel_policy many_threads = {8, 1};
+    BOOST_CHECK_EQUAL(monad::reduce(many_threads, checked_sum, 0, few_values),
+                      monad::maybe<long>{6});
+}
+
+
+constexpr monad::maybe<int> checked_half (int x)
+{ return x % 2 == 0 ? monad::maybe<int>{x / 2} : monad::nothing; }
+
+constexpr monad::maybe<double> checked_inverse (int x)
+{ return x ? monad::maybe<double>{1.0 / x} : monad::nothing; }
+
+BOOST_AUTO_TEST_CASE(kleisli)
+{
+    auto quarter = monad::compose_k(checked_half, checked_half);
+    auto inverse_quarter = monad::compose_k(checked_half) >= checked_half >= checked_inverse;
+
+    BOOST_CHECK_EQUAL(quarter(8), monad::maybe<int>{2});
+    BOOST_CHECK_EQUAL(quarter(6), monad::nothing);
+    BOOST_CHECK_EQUAL(quarter(3), monad::nothing);
+
+    BOOST_CHECK_EQUAL(inverse_quarter(8), monad::maybe<double>{0.5});
+    BOOST_CHECK_EQUAL(inverse_quarter(0), monad::nothing);
+    BOOST_CHECK_EQUAL(inverse_quarter(6), monad::nothing);
+
+    // Same as the nested >>= form.
+    for (int i = -16; i <= 16; ++i) {
+        auto const nested = checked_half(i) >>= [](int x) {
+            return checked_half(x) >>= [](int y) {
+                return checked_inverse(y);
+            };
+        };
+        BOOST_CHECK_EQUAL(inverse_quarter(i), nested);
+    }
+
+    // Composing compositions.
+    auto sixteenth = quarter >= quarter;
+    BOOST_CHECK_EQUAL(sixteenth(32), monad::maybe<int>{2});
+    BOOST_CHECK_EQUAL(sixteenth(24), monad::nothing);
+
+    constexpr auto constexpr_quarter = monad::compose_k(checked_half, checked_half);
+    static_assert(constexpr_quarter(12) == monad::maybe<int>{3}, "");
+    static_assert(constexpr_quarter(10) == monad::nothing, "");
+}
+
+
+BOOST_AUTO_TEST_CASE(maybe_special_members)
+{
+    static_assert(std::is_trivially_copyable<monad::maybe<int>>::value, "");
+    static_assert(std::is_trivially_copy_constructible<monad::maybe<int>>::value, "");
+    static_assert(std::is_trivially_move_constructible<monad::maybe<int>>::value, "");
+    static_assert(std::is_trivially_copy_assignable<monad::maybe<int>>::value, "");
+    static_assert(std::is_trivially_move_assignable<monad::maybe<int>>::value, "");
+    static_assert(std::is_trivially_destructible<monad::maybe<int>>::value, "");
+    static_assert(std::is_trivially_copyable<monad::maybe<std::array<double, 4>>>::value, "");
+
+    static_assert(!std::is_trivially_copyable<monad::maybe<std::string>>::value, "");
+    static_assert(!std::is_trivially_destructible<monad::maybe<std::string>>::value, "");
+    static_assert(std::is_nothrow_move_constructible<monad::maybe<std::string>>::value, "");
+    static_assert(std::is_nothrow_move_assignable<monad::maybe<std::string>>::value, "");
+    static_assert(std::is_nothrow_move_constructible<monad::maybe<std::vector<int>>>::value, "");
+    static_assert(!std::is_nothrow_copy_constructible<monad::maybe<std::string>>::value, "");
+
+    // Moves leave the source valid, and do not affect the state.
+    monad::maybe<std::string> abc = std::string("abc");
+    monad::maybe<std::string> moved_to = std::move(abc);
+    BOOST_CHECK_EQUAL(moved_to, monad::maybe<std::string>{"abc"});
+
+    monad::maybe<std::string> nothing = monad::nothing;
+    moved_to = std::move(nothing);
+    BOOST_CHECK_EQUAL(moved_to, monad::nothing);
+}
+
+
+BOOST_AUTO_TEST_CASE(maybe_references)
+{
+    static_assert(sizeof(monad::maybe<std::string const &>) == sizeof(void *), "");
+    static_assert(std::is_trivially_copyable<monad::maybe<std::string const &>>::value, "");
+    static_assert(!std::is_constructible<monad::maybe<std::string const &>, std::string &&>::value, "");
+
+    std::map<int, std::string> const names = {
+        {1, std::string(1000, 'a')},
+        {2, std::string(1000, 'b')},
+        {3, std::string(1000, 'c')}
+    };
+
+    auto lookup = [&names](int key) {
+        auto const it = names.find(key);
+        if (it == names.end())
+            return monad::maybe<std::string const &>{monad::nothing};
+        return monad::maybe<std::string const &>{it->second};
+    };
+
+    // The continuation gets the element itself, not a copy.
+    std::string const * seen = nullptr;
+    auto address = lookup(2) >>= [&seen](std::string const & s) {
+        seen = &s;
+        return monad::maybe<std::size_t>{s.size()};
+    };
+    BOOST_CHECK_EQUAL(seen, &names.at(2));
+    BOOST_CHECK_EQUAL(address, monad::maybe<std::size_t>{1000});
+    BOOST_CHECK_EQUAL(&lookup(3).value(), &names.at(3));
+    BOOST_CHECK_EQUAL(lookup(4), monad::nothing);
+    auto first_char = [](std::string const & s) {
+        return monad::maybe<char const &>{s[0]};
+    };
+    BOOST_CHECK_EQUAL(&(lookup(1) >>= first_char).value(), names.at(1).data());
+    BOOST_CHECK_EQUAL(lookup(4) >>= first_char, monad::nothing);
+
+    BOOST_CHECK(lookup(1) == lookup(1));
+    BOOST_CHECK(lookup(1) != lookup(2));
+
+    int x = 1;
+    monad::maybe<int &> rx = x;
+    BOOST_CHECK_EQUAL(&monad::fmap([](int & i) -> int & {return ++i;}, rx).value(), &x);
+    BOOST_CHECK_EQUAL(x, 2);
+
+    auto total_size = [](std::string const & a, std::string const & b) {
+        return a.size() + b.size();
+    };
+    BOOST_CHECK_EQUAL(
+        monad::lift_n<monad::maybe<std::size_t>>(total_size, lookup(1), lookup(3)),
+        monad::maybe<std::size_t>{2000}
+    );
+    BOOST_CHECK_EQUAL(
+        monad::lift_n<monad::maybe<std::size_t>>(total_size, lookup(1), lookup(5)),
+        monad::nothing
+    );
+
+    {
+        std::vector<monad::maybe<std::string const &>> lookups = {lookup(1), lookup(2)};
+        auto result = monad::sequence(lookups);
+        static_assert(
+            std::is_same<
+                decltype(result)::value_type,
+                std::vector<std::reference_wrapper<std::string const>>
+            >::value,
+            ""
+        );
+        BOOST_CHECK(result.state().nonempty_);
+        BOOST_CHECK_EQUAL(result.value().size(), 2u);
+        BOOST_CHECK_EQUAL(&result.value()[0].get(), &names.at(1));
+        BOOST_CHECK_EQUAL(&result.value()[1].get(), &names.at(2));
+
+        lookups.push_back(lookup(7));
+        BOOST_CHECK_EQUAL(monad::sequence(lookups).state().nonempty_, false);
+    }
+
+    {
+        std::vector<int> const keys = {3, 1, 2};
+        auto result = monad::map(lookup, keys);
+        BOOST_CHECK(result.state().nonempty_);
+        BOOST_CHECK_EQUAL(&result.value()[0].get(), &names.at(3));
+        BOOST_CHECK_EQUAL(&result.value()[2].get(), &names.at(2));
+
+        BOOST_CHECK_EQUAL(monad::replicate(2, lookup(1)).value().size(), 2u);
+    }
+
+    // A failed maybe<T &> refers to nothing, so sequence() and map() must
+    // stop at the first failure rather than read the failed value.
+    {
+        std::vector<monad::maybe<std::string const &>> const lookups =
+            {lookup(1), lookup(7), lookup(2)};
+        BOOST_CHECK_EQUAL(monad::sequence(lookups).state().nonempty_, false);
+
+        int calls = 0;
+        auto counted_lookup = [&](int key) {
+            ++calls;
+            return lookup(key);
+        };
+        std::vector<int> const keys = {1, 7, 2};
+        BOOST_CHECK_EQUAL(monad::map(counted_lookup, keys).state().nonempty_, false);
+        BOOST_CHECK_EQUAL(calls, 2);
+    }
+
+    // Views are cheap to copy, and behave like any other payload.
+    {
+        std::string const text = "alpha beta";
+        auto word = [&text](std::size_t i) {
+            if (i > 1)
+                return monad::maybe<std::string_view>{monad::nothing};
+            std::string_view const v = text;
+            return monad::maybe<std::string_view>{i ? v.substr(6) : v.substr(0, 5)};
+        };
+        std::vector<std::size_t> const indices = {0, 1};
+        auto words = monad::map(word, indices);
+        BOOST_CHECK(words.state().nonempty_);
+        BOOST_CHECK_EQUAL(words.value()[1], "beta");
+        BOOST_CHECK_EQUAL(words.value()[1].data(), text.data() + 6);
+        BOOST_CHECK_EQUAL(monad::map(word, std::vector<std::size_t>{1, 2}), monad::nothing);
+    }
+
+#if __cplusplus > 201703L
+    {
+        std::vector<int> const data = {1, 2, 3, 4, 5, 6};
+        auto row = [&data](std::size_t i) {
+            if (i > 2)
+                return monad::maybe<std::span<int const>>{monad::nothing};
+            return monad::maybe<std::span<int const>>{
+                std::span<int const>(data).subspan(2 * i, 2)
+            };
+        };
+        std::vector<std::size_t> const indices = {2, 0};
+        auto rows = monad::map(row, indices);
+        BOOST_CHECK(rows.state().nonempty_);
+        BOOST_CHECK_EQUAL(rows.value()[0].data(), data.data() + 4);
+        BOOST_CHECK_EQUAL(rows.value()[1].size(), 2u);
+    }
+#endif
+}
+
+
+BOOST_AUTO_TEST_CASE(discarding_algorithms)
+{
+    monad::maybe<monad::unit> const ok = monad::unit{};
+
+    std::vector<monad::maybe<int>> no_maybes;
+    std::vector<monad::maybe<int>> bad_maybes = {0, monad::nothing, 3};
+    std::vector<monad::maybe<int>> good_maybes = {-1, 0, 3};
+
+    BOOST_CHECK_EQUAL(monad::sequence_(no_maybes), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::sequence_(bad_maybes), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::sequence_(good_maybes), ok);
+
+
+    // map_ and for_
+
+    std::vector<int> empty_set;
+    std::vector<int> set_123 = {1, 2, 3};
+    std::vector<int> set_204 = {2, 0, 4};
+
+    int calls = 0;
+    auto count_nonzero = [&calls](int x) {
+        ++calls;
+        return x ? monad::maybe<int>{x} : monad::nothing;
+    };
+
+    BOOST_CHECK_EQUAL(monad::map_(count_nonzero, empty_set), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::map_(count_nonzero, set_123), ok);
+    BOOST_CHECK_EQUAL(calls, 3);
+
+    // Stops at the first failure.
+    calls = 0;
+    BOOST_CHECK_EQUAL(monad::map_(count_nonzero, set_204), monad::nothing);
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    BOOST_CHECK_EQUAL(monad::for_(set_123, count_nonzero), ok);
+    BOOST_CHECK_EQUAL(monad::for_(set_204, count_nonzero), monad::nothing);
+
+
+    // zip_
+
+    std::vector<float> set_neg_111_float = {-1.0f, -1.0f, -1.0f};
+    std::vector<float> set_024_float = {0.0f, 2.0f, 4.0f};
+
+    auto zip_sum_nonzero = [](int lhs, float rhs) {
+        float sum = lhs + rhs;
+        return sum ? monad::maybe<double>{1.0 * sum} : monad::nothing;
+    };
+
+    BOOST_CHECK_EQUAL(monad::zip_(zip_sum_nonzero, empty_set, set_024_float), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::zip_(zip_sum_nonzero, set_123, set_024_float), ok);
+    BOOST_CHECK_EQUAL(monad::zip_(zip_sum_nonzero, set_123, set_neg_111_float), monad::nothing);
+
+
+    // replicate and replicate_
+
+    monad::maybe<int> m_nothing = monad::nothing;
+    monad::maybe<int> m_3 = 3;
+
+    BOOST_CHECK_EQUAL(monad::replicate(0, m_3), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::replicate(3, m_nothing), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::replicate(3, m_3), (monad::maybe<std::vector<int>>{{3, 3, 3}}));
+    BOOST_CHECK_EQUAL(monad::replicate(1000, m_3).value().capacity(), 1000u);
+
+    BOOST_CHECK_EQUAL(monad::replicate_(0, m_3), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::replicate_(3, m_nothing), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::replicate_(3, m_3), ok);
+}
+
+
+BOOST_AUTO_TEST_CASE(pipeline)
+{
+    auto decode = [](int x) {
+        return 0 <= x ? monad::maybe<long>{x * 10L} : monad::nothing;
+    };
+    auto validate = [](long x) {
+        return x % 3 ? monad::maybe<long>{x} : monad::nothing;
+    };
+    auto enrich = [](long x) {
+        return monad::maybe<double>{x + 0.5};
+    };
+
+    std::vector<int> inputs;
+    for (int i = -10; i < 1000; ++i) {
+        inputs.push_back(i);
+    }
+
+    std::vector<double> expected;
+    std::size_t expected_rejects[3] = {0, 0, 0};
+    auto const composed = monad::compose_k(decode, validate, enrich);
+    for (int x : inputs) {
+        auto const m = composed(x);
+        if (m != monad::nothing)
+            expected.push_back(m.value());
+        else if (x < 0)
+            ++expected_rejects[0];
+        else
+            ++expected_rejects[1];
+    }
+
+    // A capacity of 2 makes the stages block on each other.
+    for (std::size_t capacity : {2u, 1024u}) {
+        std::vector<double> outputs;
+        std::size_t rejects[3] = {0, 0, 0};
+        auto const p = monad::make_pipeline(capacity, decode, validate, enrich);
+        auto const stats = p.run(
+            inputs,
+            [&outputs](double x) {outputs.push_back(x);},
+            [&rejects](std::size_t stage, auto const &) {++rejects[stage];}
+        );
+
+        BOOST_CHECK(outputs == expected);
+        BOOST_CHECK_EQUAL(rejects[0], expected_rejects[0]);
+        BOOST_CHECK_EQUAL(rejects[1], expected_rejects[1]);
+        BOOST_CHECK_EQUAL(rejects[2], 0u);
+
+        BOOST_CHECK_EQUAL(stats.inputs, inputs.size());
+        BOOST_CHECK_EQUAL(stats.outputs, expected.size());
+        BOOST_CHECK_EQUAL(stats.stages.size(), 3u);
+        BOOST_CHECK_EQUAL(stats.stages[0].processed, inputs.size());
+        BOOST_CHECK_EQUAL(stats.stages[0].rejected, expected_rejects[0]);
+        BOOST_CHECK_EQUAL(stats.stages[1].processed, inputs.size() - expected_rejects[0]);
+        BOOST_CHECK_EQUAL(stats.stages[1].rejected, expected_rejects[1]);
+        BOOST_CHECK_EQUAL(stats.stages[2].processed, expected.size());
+    }
+
+    // From a Kleisli composition, dropping rejects.
+    {
+        std::vector<double> outputs;
+        auto const p = monad::make_pipeline(16, composed);
+        BOOST_CHECK_EQUAL(p.size, 3u);
+        p.run(inputs.begin(), inputs.end(), [&outputs](double x) {outputs.push_back(x);});
+        BOOST_CHECK(outputs == expected);
+    }
+
+    // Exceptions stop the run and are rethrown.
+    {
+        auto throw_on_500 = [](long x) {
+            if (x == 5000)
+                throw std::runtime_error("500");
+            return monad::maybe<long>{x};
+        };
+        auto const p = monad::make_pipeline(4, decode, throw_on_500, enrich);
+        BOOST_CHECK_THROW(p.run(inputs, [](double) {}), std::runtime_error);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(memoize)
+{
+    std::atomic<int> calls{0};
+    auto checked_half = [&calls](int x) {
+        ++calls;
+        return x % 2 == 0 ? monad::maybe<int>{x / 2} : monad::nothing;
+    };
+
+    auto const memo_half = monad::memoize(checked_half, 100);
+
+    BOOST_CHECK_EQUAL(memo_half(8), monad::maybe<int>{4});
+    BOOST_CHECK_EQUAL(memo_half(8), monad::maybe<int>{4});
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    // nothing is cached too, unless asked otherwise.
+    BOOST_CHECK_EQUAL(memo_half(3), monad::nothing);
+    BOOST_CHECK_EQUAL(memo_half(3), monad::nothing);
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    auto const stats = memo_half.stats();
+    BOOST_CHECK_EQUAL(stats.hits, 2u);
+    BOOST_CHECK_EQUAL(stats.misses, 2u);
+    BOOST_CHECK_EQUAL(stats.size, 2u);
+    BOOST_CHECK_CLOSE(stats.hit_rate(), 0.5, 1.0e-5);
+
+    monad::memoize_options no_failures;
+    no_failures.cache_failures = false;
+    auto const memo_half_no_failures = monad::memoize(checked_half, 100, no_failures);
+    calls = 0;
+    BOOST_CHECK_EQUAL(memo_half_no_failures(3), monad::nothing);
+    BOOST_CHECK_EQUAL(memo_half_no_failures(3), monad::nothing);
+    BOOST_CHECK_EQUAL(calls, 2);
+
+
+    // Bounded.
+
+    monad::memoize_options one_shard;
+    one_shard.shards = 1;
+    auto const small_memo = monad::memoize(checked_half, 8, one_shard);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(small_memo(i), checked_half(i));
+    }
+    BOOST_CHECK_EQUAL(small_memo.stats().size, 8u);
+    BOOST_CHECK_EQUAL(small_memo.stats().evictions, 92u);
+
+
+    // Usable wherever the function is.
+
+    std::vector<int> set_248 = {2, 4, 8};
+    std::vector<int> set_234 = {2, 3, 4};
+
+    BOOST_CHECK_EQUAL((monad::maybe<int>{8} >>= memo_half), monad::maybe<int>{4});
+    BOOST_CHECK_EQUAL(monad::map(memo_half, set_248), (monad::maybe<std::vector<int>>{{1, 2, 4}}));
+    BOOST_CHECK_EQUAL(monad::map(memo_half, set_234), monad::nothing);
+
+    auto const memo_sum = monad::memoize([](int lhs, int rhs) {
+        return monad::maybe<int>{lhs + rhs};
+    }, 100);
+    BOOST_CHECK_EQUAL(monad::fold(memo_sum, 0, set_248), monad::maybe<int>{14});
+
+    auto const memo_add3 = monad::memoize(add3<int>, 100);
+    BOOST_CHECK_EQUAL(
+        (monad::lift_n<monad::maybe<int>>(memo_add3, monad::maybe<int>{1}, monad::maybe<int>{2}, monad::maybe<int>{3})),
+        monad::maybe<int>{6}
+    );
+
+    // Generic lambdas need their argument types.
+    auto const memo_generic = monad::memoize<int>([](auto x) {
+        return monad::maybe<int>{x * 2};
+    }, 100);
+    BOOST_CHECK_EQUAL(memo_generic(21), monad::maybe<int>{42});
+
+    // A hit looks the arguments up in place, without copying them into a
+    // key.
+    auto const memo_length = monad::memoize([](std::string const & s) {
+        return monad::maybe<std::size_t>{s.size()};
+    }, 100);
+    std::string const long_string(1000, 'x');
+    BOOST_CHECK_EQUAL(memo_length(long_string), monad::maybe<std::size_t>{1000});
+    std::size_t const before = allocations.load();
+    BOOST_CHECK_EQUAL(memo_length(long_string), monad::maybe<std::size_t>{1000});
+    BOOST_CHECK_EQUAL(allocations.load() - before, 0u);
+    BOOST_CHECK_EQUAL(memo_length.stats().hits, 1u);
+
+
+    // Shared by concurrent callers.
+
+    std::vector<long> values(20000);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = i % 100;
+    }
+    auto const memo_checked_sum = monad::memoize([](long lhs, long rhs) {
+        return 0 <= rhs ? monad::maybe<long>{lhs + rhs} : monad::nothing;
+    }, 1000);
+    monad::parallel_policy four_threads = {4, 16};
+    BOOST_CHECK_EQUAL(monad::reduce(four_threads, memo_checked_sum, 0, values),
+                      monad::fold(memo_checked_sum, 0, values));
+}
+
+
+BOOST_AUTO_TEST_CASE(parser)
+{
+    using monad::parsed;
+
+    {
+        std::string_view const input = "-42,x";
+        auto const result = monad::int_(input);
+        BOOST_CHECK(result.state().ok);
+        BOOST_CHECK_EQUAL(result.value(), -42);
+        BOOST_CHECK_EQUAL(result.state().rest, ",x");
+        BOOST_CHECK_EQUAL(result.state().rest.data(), input.data() + 3);
+
+        auto const failed = monad::int_(result.state().rest);
+        BOOST_CHECK(!failed.state().ok);
+        BOOST_CHECK_EQUAL(failed.state().rest, ",x");
+
+        BOOST_CHECK(monad::char_(',')(",x").state().ok);
+        BOOST_CHECK(!monad::char_(',')("x").state().ok);
+        BOOST_CHECK(!monad::char_()("").state().ok);
+        BOOST_CHECK(monad::eoi("").state().ok);
+        BOOST_CHECK(!monad::eoi("x").state().ok);
+    }
+
+    // >>= threads the remaining input through the continuations.
+    {
+        auto const pair = monad::int_ >>= [](int x) {
+            return monad::char_(':') >> monad::int_ >>= [x](int y) {
+                return parsed<int>{x * y};
+            };
+        };
+        auto const result = pair("6:7;");
+        BOOST_CHECK_EQUAL(result.value(), 42);
+        BOOST_CHECK_EQUAL(result.state().rest, ";");
+
+        auto const failed = pair("6;7");
+        BOOST_CHECK(!failed.state().ok);
+        BOOST_CHECK_EQUAL(failed.state().rest, ";7");
+
+        auto const positive = monad::int_ >>= [](int x) {
+            return 0 < x ? parsed<int>{x} : parsed<int>{monad::nothing};
+        };
+        BOOST_CHECK(positive("3").state().ok);
+        BOOST_CHECK(!positive("-3").state().ok);
+        BOOST_CHECK_EQUAL(positive("-3").state().rest, "");
+    }
+
+    // lift_n(), <<, | and take_while() / lit().
+    {
+        struct field
+        {
+            std::string_view name;
+            int value;
+        };
+        auto const name = monad::take_while([](char c) {return c != '=';});
+        auto const boolean =
+            (monad::lit("true") >> monad::pure(1)) |
+            (monad::lit("false") >> monad::pure(0));
+        auto const value = monad::int_ | boolean;
+        auto const field_ = monad::lift_n<parsed<field>>(
+            [](std::string_view n, int v) {return field{n, v};},
+            name << monad::char_('='),
+            value
+        );
+
+        std::string_view const input = "size=12";
+        auto const result = field_(input);
+        BOOST_CHECK(result.state().ok);
+        BOOST_CHECK_EQUAL(result.value().name, "size");
+        BOOST_CHECK_EQUAL(result.value().name.data(), input.data());
+        BOOST_CHECK_EQUAL(result.value().value, 12);
+        BOOST_CHECK_EQUAL(field_("flag=true").value().value, 1);
+        BOOST_CHECK_EQUAL(field_("flag=false").value().value, 0);
+        BOOST_CHECK(!field_("flag=maybe").state().ok);
+        BOOST_CHECK(!field_("flag").state().ok);
+    }
+
+    // many() and sep_by() write into the caller's container.
+    {
+        std::vector<int> values;
+        values.reserve(8);
+        auto const list = monad::sep_by(monad::int_, monad::char_(','), values);
+        auto const result = list("1,2,3,x");
+        BOOST_CHECK_EQUAL(result.value(), 3u);
+        BOOST_CHECK_EQUAL(result.state().rest, ",x");
+        BOOST_CHECK(values == (std::vector<int>{1, 2, 3}));
+
+        values.clear();
+        BOOST_CHECK_EQUAL(list("x").value(), 0u);
+        BOOST_CHECK(list("x").state().ok);
+        BOOST_CHECK(values.empty());
+
+        auto const digits = monad::many(monad::char_if([](char c) {
+            return '0' <= c && c <= '9';
+        }));
+        auto const many_result = digits("123ab");
+        BOOST_CHECK(many_result.value() == (std::vector<char>{'1', '2', '3'}));
+        BOOST_CHECK_EQUAL(many_result.state().rest, "ab");
+
+        auto const rows = monad::sep_by(
+            monad::sep_by(monad::int_, monad::char_(',')),
+            monad::char_('\n')
+        );
+        auto const table = rows("1,2\n3\n4,5,6");
+        BOOST_CHECK_EQUAL(table.value().size(), 3u);
+        BOOST_CHECK(table.value()[2] == (std::vector<int>{4, 5, 6}));
+        BOOST_CHECK_EQUAL(table.state().rest, "");
+    }
+
+    // sequence() runs a run-time list of parsers one after another.
+    {
+        using word = decltype(monad::lit(""));
+        std::vector<word> const words = {
+            monad::lit("let"),
+            monad::lit(" "),
+            monad::lit("x")
+        };
+        auto const let_x = monad::sequence(words);
+        auto const result = let_x("let x = 1");
+        BOOST_CHECK(result.state().ok);
+        BOOST_CHECK(result.value() == (std::vector<std::string_view>{"let", " ", "x"}));
+        BOOST_CHECK_EQUAL(result.state().rest, " = 1");
+
+        auto const failed = let_x("let y");
+        BOOST_CHECK(!failed.state().ok);
+        BOOST_CHECK_EQUAL(failed.state().rest, "y");
+
+        std::vector<std::string_view> out;
+        auto const counted = monad::sequence(words, out)("let x");
+        BOOST_CHECK_EQUAL(counted.value(), 3u);
+        BOOST_CHECK_EQUAL(out.size(), 3u);
+
+        std::vector<word> const none;
+        BOOST_CHECK(monad::sequence(none)("abc").value().empty());
+    }
+
+    // A successful parse does not allocate, however many combinators it
+    // goes through, when sep_by() writes into a container with room.
+    {
+        auto const key = monad::take_while([](char c) {return c != '=';});
+        auto const boolean =
+            (monad::lit("true") >> monad::pure(1)) |
+            (monad::lit("false") >> monad::pure(0));
+        auto const pair = monad::lift_n<parsed<int>>(
+            [](std::string_view k, int v) {return static_cast<int>(k.size()) + v;},
+            key << monad::char_('='),
+            monad::int_ | boolean
+        );
+        auto const product = monad::int_ >>= [](int x) {
+            return monad::char_('*') >> monad::int_ >>= [x](int y) {
+                return parsed<int>{x * y};
+            };
+        };
+        std::vector<int> values;
+        values.reserve(8);
+        auto const list = monad::sep_by(pair, monad::char_(','), values);
+
+        std::string_view const input = "a=1,bb=true,ccc=false,d=-4";
+        std::size_t const before = allocations.load();
+        auto const list_result = list(input);
+        auto const product_result = product("6*7");
+        auto const eoi_result = (product << monad::eoi)("2*3");
+        std::size_t const after = allocations.load();
+
+        BOOST_CHECK_EQUAL(after - before, 0u);
+        BOOST_CHECK(list_result.state().ok);
+        BOOST_CHECK_EQUAL(list_result.value(), 4u);
+        BOOST_CHECK_EQUAL(list_result.state().rest, "");
+        BOOST_CHECK(values == (std::vector<int>{2, 3, 3, -3}));
+        BOOST_CHECK_EQUAL(product_result.value(), 42);
+        BOOST_CHECK_EQUAL(eoi_result.value(), 6);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(dataflow)
+{
+    using monad::maybe;
+
+    monad::dataflow graph;
+    auto a = graph.input(maybe<int>{1});
+    auto b = graph.input(maybe<int>{2});
+
+    int sum_calls = 0;
+    auto sum = monad::lift_n<maybe<int>>(
+        [&sum_calls](int x, int y) {++sum_calls; return x + y;},
+        a,
+        b
+    );
+    int parity_calls = 0;
+    auto parity = monad::lift_n<maybe<int>>(
+        [&parity_calls](int x) {++parity_calls; return x % 2;},
+        sum
+    );
+    int diamond_calls = 0;
+    auto diamond = monad::lift_n<maybe<int>>(
+        [&diamond_calls](int x, int y, int z) {++diamond_calls; return x * 100 + y * 10 + z;},
+        sum,
+        parity,
+        a
+    );
+
+    BOOST_CHECK_EQUAL(graph.size(), 5u);
+    BOOST_CHECK_EQUAL(sum.value(), maybe<int>{3});
+    BOOST_CHECK_EQUAL(parity.value(), maybe<int>{1});
+    BOOST_CHECK_EQUAL(diamond.value(), maybe<int>{311});
+    BOOST_CHECK_EQUAL(graph.update(), 0u);
+
+    // Each affected cell is recomputed once, after all of its arguments.
+    a.set(maybe<int>{2});
+    BOOST_CHECK_EQUAL(graph.update(), 3u);
+    BOOST_CHECK_EQUAL(sum_calls, 2);
+    BOOST_CHECK_EQUAL(parity_calls, 2);
+    BOOST_CHECK_EQUAL(diamond_calls, 2);
+    BOOST_CHECK_EQUAL(diamond.value(), maybe<int>{402});
+
+    // Setting an equal value does nothing.
+    a.set(maybe<int>{2});
+    BOOST_CHECK_EQUAL(graph.update(), 0u);
+
+    // parity's value does not change, so it does not propagate, but
+    // diamond still depends directly on sum.
+    a.set(maybe<int>{4});
+    BOOST_CHECK_EQUAL(graph.update(), 3u);
+    BOOST_CHECK_EQUAL(sum_calls, 3);
+    BOOST_CHECK_EQUAL(parity_calls, 3);
+    BOOST_CHECK_EQUAL(diamond_calls, 3);
+    BOOST_CHECK_EQUAL(diamond.value(), maybe<int>{604});
+
+    // A change whose result is unchanged stops at once.
+    a.set(maybe<int>{2});
+    b.set(maybe<int>{4});
+    BOOST_CHECK_EQUAL(graph.update(), 2u);
+    BOOST_CHECK_EQUAL(sum_calls, 4);
+    BOOST_CHECK_EQUAL(diamond_calls, 4);
+    BOOST_CHECK_EQUAL(diamond.value(), maybe<int>{602});
+
+    auto independent = graph.input(maybe<int>{7});
+    auto doubled = monad::lift_n<maybe<int>>([](int x) {return 2 * x;}, independent);
+    BOOST_CHECK_EQUAL(graph.update(), 0u);
+    BOOST_CHECK_EQUAL(doubled.value(), maybe<int>{14});
+    independent.set(maybe<int>{8});
+    BOOST_CHECK_EQUAL(graph.update(), 1u);
+    BOOST_CHECK_EQUAL(doubled.value(), maybe<int>{16});
+    BOOST_CHECK_EQUAL(diamond_calls, 4);
+
+    // nothing propagates to nothing, and then stops.
+    b.set(monad::nothing);
+    BOOST_CHECK_EQUAL(graph.update(), 3u);
+    BOOST_CHECK_EQUAL(sum.value(), monad::nothing);
+    BOOST_CHECK_EQUAL(diamond.value(), monad::nothing);
+    BOOST_CHECK_EQUAL(sum_calls, 4);
+
+    a.set(maybe<int>{5});
+    BOOST_CHECK_EQUAL(graph.update(), 2u);
+    BOOST_CHECK_EQUAL(sum_calls, 4);
+    BOOST_CHECK_EQUAL(diamond_calls, 4);
+    BOOST_CHECK_EQUAL(diamond.value(), monad::nothing);
+
+    BOOST_CHECK_THROW(sum.set(maybe<int>{0}), std::logic_error);
+
+    // A cell whose function throws stays queued, and the next update()
+    // recomputes it and its dependents.
+    {
+        monad::dataflow g;
+        auto x = g.input(maybe<int>{1});
+        bool fail = false;
+        auto checked = monad::lift_n<maybe<int>>(
+            [&fail](int v) {
+                if (fail)
+                    throw std::runtime_error("check failed");
+                return v + 1;
+            },
+            x
+        );
+        auto squared = monad::lift_n<maybe<int>>([](int v) {return v * v;}, checked);
+        BOOST_CHECK_EQUAL(squared.value(), maybe<int>{4});
+
+        fail = true;
+        x.set(maybe<int>{2});
+        BOOST_CHECK_THROW(g.update(), std::runtime_error);
+        BOOST_CHECK_EQUAL(checked.value(), maybe<int>{2});
+        BOOST_CHECK_EQUAL(squared.value(), maybe<int>{4});
+
+        fail = false;
+        BOOST_CHECK_EQUAL(g.update(), 2u);
+        BOOST_CHECK_EQUAL(checked.value(), maybe<int>{3});
+        BOOST_CHECK_EQUAL(squared.value(), maybe<int>{9});
+        BOOST_CHECK_EQUAL(g.update(), 0u);
+    }
+
+    monad::dataflow other;
+    auto foreign = other.input(maybe<int>{0});
+    BOOST_CHECK_THROW(
+        monad::lift_n<maybe<int>>([](int x, int y) {return x + y;}, a, foreign),
+        std::invalid_argument
+    );
+}
+
+
+BOOST_AUTO_TEST_CASE(batched_algorithms)
+{
+    using monad::maybe;
+    using monad::span;
+
+    auto halve = [](int x) {
+        return x % 2 ? maybe<int>{monad::nothing} : maybe<int>{x / 2};
+    };
+    auto halve_kernel = [](span<int const> in, span<int> out, span<bool> valid) {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = in[i] / 2;
+            valid[i] = in[i] % 2 == 0;
+        }
+    };
+
+    std::vector<int> evens(100);
+    for (std::size_t i = 0; i < evens.size(); ++i) {
+        evens[i] = 2 * int(i);
+    }
+    std::vector<int> odd_last = evens;
+    odd_last.back() = 7;
+
+    // Chunk sizes that do and do not divide the input evenly give the same
+    // results as the per-element algorithms.
+    for (std::size_t chunk : {std::size_t(0), std::size_t(1), std::size_t(7), std::size_t(100)}) {
+        monad::batched_policy const policy{chunk};
+        BOOST_CHECK(monad::map(policy, halve_kernel, evens) == monad::map(halve, evens));
+        BOOST_CHECK_EQUAL(monad::map(policy, halve_kernel, odd_last), monad::nothing);
+    }
+    BOOST_CHECK_EQUAL(monad::map(monad::batched, halve_kernel, std::vector<int>{}), monad::nothing);
+
+    // No chunks are processed after a failure.
+    int chunks = 0;
+    auto counting_kernel = [&chunks](span<int const> in, span<int> out, span<bool> valid) {
+        ++chunks;
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = in[i];
+            valid[i] = in[i] != 0;
+        }
+    };
+    BOOST_CHECK_EQUAL(monad::map(monad::batched_policy{10}, counting_kernel, evens), monad::nothing);
+    BOOST_CHECK_EQUAL(chunks, 1);
+
+    auto ratio_kernel = [](span<int const> lhs, span<double const> rhs, span<double> out, span<bool> valid) {
+        for (std::size_t i = 0; i < lhs.size(); ++i) {
+            valid[i] = rhs[i] != 0.0;
+            out[i] = valid[i] ? lhs[i] / rhs[i] : 0.0;
+        }
+    };
+    std::vector<int> const numerators = {1, 2, 3, 4, 5};
+    std::vector<double> const denominators = {1.0, 2.0, 4.0, 8.0, 10.0};
+    auto const ratios = monad::zip(monad::batched_policy{2}, ratio_kernel, numerators, denominators);
+    BOOST_CHECK(ratios == (maybe<std::vector<double>>{{1.0, 1.0, 0.75, 0.5, 0.5}}));
+    std::vector<double> const zeros = {1.0, 1.0, 1.0, 1.0, 0.0};
+    BOOST_CHECK_EQUAL(monad::zip(monad::batched_policy{2}, ratio_kernel, numerators, zeros), monad::nothing);
+
+    // Sums until the total exceeds a limit.
+    auto bounded_sum = [](int acc, span<int const> in) {
+        for (int x : in) {
+            acc += x;
+            if (1000 < acc)
+                return maybe<int>{monad::nothing};
+        }
+        return maybe<int>{acc};
+    };
+    std::vector<int> const small(40, 5);
+    BOOST_CHECK_EQUAL(monad::fold(monad::batched_policy{16}, bounded_sum, 1, small), maybe<int>{201});
+    BOOST_CHECK_EQUAL(monad::fold(monad::batched, bounded_sum, 1, evens), monad::nothing);
+    BOOST_CHECK_EQUAL(monad::fold(monad::batched, bounded_sum, 1, std::vector<int>{}), monad::nothing);
+
+    // A mask kernel, whose output is a span<bool>.
+    auto big_kernel = [](span<int const> in, span<bool> out, span<bool> valid) {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = 100 < in[i];
+            valid[i] = 0 <= in[i];
+        }
+    };
+    auto const mask = monad::map(monad::batched_policy{7}, big_kernel, evens);
+    BOOST_CHECK(mask.state().nonempty_);
+    BOOST_CHECK_EQUAL(mask.value().size(), evens.size());
+    BOOST_CHECK(!mask.value()[50]);
+    BOOST_CHECK(mask.value()[51]);
+    std::vector<int> const negative = {1, -1};
+    BOOST_CHECK_EQUAL(monad::map(monad::batched, big_kernel, negative), monad::nothing);
+
+    // A kernel whose flags are states: validated's do not short-circuit,
+    // so every chunk is processed and every error is kept, in order.
+    {
+        monad::error_arena arena;
+        chunks = 0;
+        auto check_kernel = [&](span<int const> in, span<int> out, span<monad::detail::validation_state> states) {
+            ++chunks;
+            for (std::size_t i = 0; i < in.size(); ++i) {
+                out[i] = in[i] / 2;
+                if (in[i] % 2)
+                    states[i] = monad::invalid<int>(arena, "x", arena.copy(std::to_string(in[i]))).state();
+            }
+        };
+        std::vector<int> const inputs = {1, 2, 4, 5, 6, 7, 8};
+        auto const checked = monad::map(monad::batched_policy{3}, check_kernel, inputs);
+        BOOST_CHECK_EQUAL(chunks, 3);
+        BOOST_CHECK_EQUAL(monad::error_count(checked), 3u);
+        auto const errors = monad::errors(checked);
+        BOOST_CHECK_EQUAL(errors[0].message, "1");
+        BOOST_CHECK_EQUAL(errors[2].message, "7");
+        BOOST_CHECK(monad::is_valid(monad::map(monad::batched, check_kernel, evens)));
+
+        auto checked_sum = [&](int acc, span<int const> in) {
+            for (int x : in) {
+                if (x < 0)
+                    return monad::invalid<int>(arena, "sum", "negative", acc);
+                acc += x;
+            }
+            return monad::valid(acc);
+        };
+        std::vector<int> const signed_values = {1, -1, 2, 3, -4, 5};
+        auto const sum = monad::fold(monad::batched_policy{2}, checked_sum, 0, signed_values);
+        BOOST_CHECK_EQUAL(monad::error_count(sum), 2u);
+        BOOST_CHECK_EQUAL(sum.value(), 6);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(small_vector)
+{
+    using monad::maybe;
+
+    {
+        monad::small_vector<std::string, 2> v;
+        BOOST_CHECK(v.empty());
+        v.push_back("a");
+        v.emplace_back(3, 'b');
+        BOOST_CHECK(v.is_inline());
+        v.push_back(v[0]);
+        BOOST_CHECK(!v.is_inline());
+        BOOST_CHECK_EQUAL(v.size(), 3u);
+        BOOST_CHECK_EQUAL(v[1], "bbb");
+        BOOST_CHECK_EQUAL(v.back(), "a");
+
+        monad::small_vector<std::string, 2> copy = v;
+        BOOST_CHECK(copy == v);
+        monad::small_vector<std::string, 2> moved = std::move(copy);
+        BOOST_CHECK(moved == v);
+        BOOST_CHECK(copy.empty());
+
+        monad::small_vector<std::string, 2> small = {"x"};
+        moved = small;
+        BOOST_CHECK(moved == small);
+        moved = std::move(v);
+        BOOST_CHECK_EQUAL(moved.size(), 3u);
+        moved.pop_back();
+        BOOST_CHECK(moved != small);
+    }
+
+    {
+        std::vector<int> const values = {1, 2, 3, 4, 5};
+        monad::small_vector<int, 2> v = {0};
+        BOOST_CHECK_EQUAL(v.insert(v.end(), values.begin(), values.end()) - v.begin(), 1);
+        BOOST_CHECK((v == monad::small_vector<int, 2>{0, 1, 2, 3, 4, 5}));
+        v.insert(v.begin() + 1, values.begin(), values.begin() + 2);
+        BOOST_CHECK((v == monad::small_vector<int, 2>{0, 1, 2, 1, 2, 3, 4, 5}));
+        std::istringstream is("7 8");
+        v.insert(v.begin(), std::istream_iterator<int>(is), std::istream_iterator<int>());
+        BOOST_CHECK((v == monad::small_vector<int, 2>{7, 8, 0, 1, 2, 1, 2, 3, 4, 5}));
+
+        BOOST_CHECK_THROW(v.reserve(v.max_size() + 1), std::length_error);
+    }
+
+    // Over-aligned elements are aligned when allocated too.
+    {
+        struct alignas(64) aligned
+        {
+            int x;
+        };
+        monad::small_vector<aligned, 1> v;
+        for (int i = 0; i < 5; ++i) {
+            v.push_back(aligned{i});
+        }
+        BOOST_CHECK(!v.is_inline());
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(v.data()) % 64, 0u);
+        BOOST_CHECK_EQUAL(v[4].x, 4);
+    }
+
+    auto half = [](int x) {
+        return x % 2 ? maybe<int>{monad::nothing} : maybe<int>{x / 2};
+    };
+    auto is_big = [](int x) {return maybe<bool>{2 < x};};
+    std::vector<int> const evens = {2, 4, 6, 8};
+
+    {
+        auto const result = monad::map<monad::small_list<8>>(half, evens);
+        static_assert(
+            std::is_same<
+                decltype(result)::value_type,
+                monad::small_vector<int, 8>
+            >::value,
+            ""
+        );
+        BOOST_CHECK(result.state().nonempty_);
+        BOOST_CHECK(result.value().is_inline());
+        BOOST_CHECK((result.value() == monad::small_vector<int, 8>{1, 2, 3, 4}));
+        BOOST_CHECK_EQUAL(
+            monad::map<monad::small_list<8>>(half, std::vector<int>{2, 3}).state().nonempty_,
+            false
+        );
+
+        auto const big = monad::filter<monad::small_list<4>>(is_big, evens);
+        BOOST_CHECK((big.value() == monad::small_vector<int, 4>{4, 6, 8}));
+
+        std::vector<maybe<int>> const maybes = {maybe<int>{1}, maybe<int>{2}};
+        static_assert(
+            monad::detail::bulk_sequenceable<
+                std::vector<maybe<int>>::const_iterator,
+                monad::small_vector<int, 2>,
+                monad::detail::maybe_state
+            >::value,
+            ""
+        );
+        auto const sequenced = monad::sequence<monad::small_list<2>>(maybes);
+        BOOST_CHECK((sequenced.value() == monad::small_vector<int, 2>{1, 2}));
+
+        auto add = [](int x, int y) {return maybe<int>{x + y};};
+        auto const sums = monad::zip<monad::small_list<4>>(add, evens, evens);
+        BOOST_CHECK((sums.value() == monad::small_vector<int, 4>{4, 8, 12, 16}));
+    }
+
+    // Inputs whose size is known at compile time give std::array results.
+    {
+        std::array<int, 3> const a = {{1, 2, 3}};
+        std::array<int, 3> const b = {{10, 20, 30}};
+        auto add = [](int x, int y) {return maybe<int>{x + y};};
+        auto const sums = monad::zip(add, a, b);
+        static_assert(
+            std::is_same<decltype(sums)::value_type, std::array<int, 3>>::value,
+            ""
+        );
+        BOOST_CHECK((sums.value() == std::array<int, 3>{{11, 22, 33}}));
+    }
+}
+
+namespace {
+
+    struct counted
+    {
+        static int copies;
+        static int moves;
+
+        counted () = default;
+        counted (int x) : x (x) {}
+        counted (counted const & other) : x (other.x) { ++copies; }
+        counted (counted && other) : x (other.x) { ++moves; }
+        counted & operator= (counted const &) = default;
+        counted & operator= (counted &&) = default;
+
+        int x = 0;
+    };
+
+    int counted::copies = 0;
+    int counted::moves = 0;
+
+    struct record
+    {
+        int id;
+        std::string name;
+        double score;
+    };
+
+}
+
+BOOST_AUTO_TEST_CASE(tuple_sequence)
+{
+    using monad::maybe;
+
+    {
+        auto const t = std::make_tuple(
+            maybe<int>{1},
+            maybe<std::string>{std::string("one")},
+            maybe<double>{1.5}
+        );
+        auto const result = monad::sequence(t);
+        static_assert(
+            std::is_same<
+                decltype(result)::value_type,
+                std::tuple<int, std::string, double>
+            >::value,
+            ""
+        );
+        BOOST_CHECK(result.state().nonempty_);
+        BOOST_CHECK((result.value() == std::make_tuple(1, std::string("one"), 1.5)));
+
+        auto const failed = monad::sequence(std::make_tuple(
+            maybe<int>{1},
+            maybe<std::string>{monad::nothing},
+            maybe<double>{1.5}
+        ));
+        BOOST_CHECK(!failed.state().nonempty_);
+
+        static_assert(
+            monad::sequence(std::make_tuple(maybe<int>{1}, maybe<char>{'a'})).value() ==
+            std::make_tuple(1, 'a'),
+            ""
+        );
+    }
+
+    // Each payload is moved exactly once from an rvalue tuple, and copied
+    // exactly once from an lvalue.
+    {
+        auto t = std::make_tuple(maybe<counted>{1}, maybe<counted>{2}, maybe<counted>{3});
+        counted::copies = 0;
+        counted::moves = 0;
+        auto const copied = monad::sequence(t);
+        BOOST_CHECK_EQUAL(counted::copies, 3);
+        BOOST_CHECK_EQUAL(counted::moves, 0);
+
+        counted::copies = 0;
+        auto const moved = monad::sequence(std::move(t));
+        BOOST_CHECK_EQUAL(counted::copies, 0);
+        BOOST_CHECK_EQUAL(counted::moves, 3);
+        BOOST_CHECK_EQUAL(std::get<2>(moved.value()).x, 3);
+    }
+
+    {
+        auto const r = monad::sequence_as<record>(std::make_tuple(
+            maybe<int>{7},
+            maybe<std::string>{std::string("seven")},
+            maybe<double>{0.5}
+        ));
+        BOOST_CHECK(r.state().nonempty_);
+        BOOST_CHECK_EQUAL(r.value().id, 7);
+        BOOST_CHECK_EQUAL(r.value().name, "seven");
+        BOOST_CHECK_EQUAL(r.value().score, 0.5);
+    }
+
+    // traverse() over heterogeneous fields, as when decoding a record.
+    {
+        struct decode
+        {
+            maybe<int> operator() (std::string_view s) const
+            {
+                int x = 0;
+                for (char c : s) {
+                    if (c < '0' || '9' < c)
+                        return monad::nothing;
+                    x = 10 * x + (c - '0');
+                }
+                return maybe<int>{x};
+            }
+            maybe<std::string> operator() (std::string const & s) const
+            { return s.empty() ? maybe<std::string>{monad::nothing} : maybe<std::string>{s}; }
+            maybe<double> operator() (double d) const
+            { return 0 <= d ? maybe<double>{d} : maybe<double>{monad::nothing}; }
+        };
+
+        std::tuple<std::string_view, std::string, double> const fields{"42", "name", 2.0};
+        auto const r = monad::traverse_as<record>(decode{}, fields);
+        BOOST_CHECK(r.state().nonempty_);
+        BOOST_CHECK_EQUAL(r.value().id, 42);
+        BOOST_CHECK_EQUAL(r.value().name, "name");
+
+        std::tuple<std::string_view, std::string, double> const bad{"4x", "name", 2.0};
+        BOOST_CHECK(!monad::traverse_as<record>(decode{}, bad).state().nonempty_);
+
+        auto const pair = monad::traverse(decode{}, std::make_pair(std::string_view("1"), 3.0));
+        BOOST_CHECK((pair.value() == std::make_tuple(1, 3.0)));
+
+        std::array<std::string_view, 3> const a = {{"1", "2", "3"}};
+        auto const from_array = monad::traverse(decode{}, a);
+        BOOST_CHECK((from_array.value() == std::make_tuple(1, 2, 3)));
+    }
+}
+
+namespace {
+
+    // A user-defined state: the number of checks made, and whether they
+    // all passed.  It uses the primary monad template; its monad_traits
+    // alone give it the short-circuiting and parallel paths.
+    struct checked_state
+    {
+        std::size_t checks = 0;
+        bool ok = true;
+    };
+
+    bool operator== (checked_state const & lhs, checked_state const & rhs)
+    { return lhs.checks == rhs.checks && lhs.ok == rhs.ok; }
+
+    template <typename T>
+    using checked = monad::monad<T, checked_state>;
+
+    // A user-defined state holding the code of the first error, or 0.
+    struct error_code_state
+    {
+        int code = 0;
+    };
+
+    template <typename T>
+    using coded = monad::monad<T, error_code_state>;
+
+}
+
+namespace monad {
+
+    template <>
+    struct monad_traits<checked_state> : default_monad_traits<checked_state>
+    {
+        static constexpr bool short_circuits = true;
+
+        static constexpr bool failed (checked_state const & state)
+        { return !state.ok; }
+
+        static constexpr bool state_independent_of_values = true;
+        static constexpr bool associative_combine = true;
+
+        static checked_state combine (checked_state const & lhs, checked_state const & rhs)
+        { return {lhs.checks + rhs.checks, lhs.ok && rhs.ok}; }
+    };
+
+    template <>
+    struct monad_traits<error_code_state> : default_monad_traits<error_code_state>
+    {
+        static constexpr bool short_circuits = true;
+
+        static constexpr bool failed (error_code_state const & state)
+        { return state.code != 0; }
+
+        static constexpr bool state_independent_of_values = true;
+        static constexpr bool associative_combine = true;
+
+        static error_code_state combine (error_code_state const & lhs, error_code_state const & rhs)
+        { return lhs.code ? lhs : rhs; }
+    };
+
+}
+
+BOOST_AUTO_TEST_CASE(monad_traits)
+{
+    using monad::identity;
+
+    {
+        static_assert(sizeof(identity<int>) == sizeof(int), "");
+
+        identity<int> const _3 = 3;
+        auto const doubled = _3 >>= [](int x) {return identity<int>{2 * x};};
+        BOOST_CHECK_EQUAL(doubled.value(), 6);
+        BOOST_CHECK(join(identity<identity<int>>{_3}) == _3);
+
+        std::vector<identity<int>> const values = {identity<int>{1}, identity<int>{2}};
+        BOOST_CHECK((monad::sequence(values).value() == std::vector<int>{1, 2}));
+        auto is_odd = [](int x) {return identity<bool>{x % 2 == 1};};
+        BOOST_CHECK((monad::filter(is_odd, std::vector<int>{1, 2, 3}).value() == std::vector<int>{1, 3}));
+
+        constexpr std::array<int, 3> a = {{1, 2, 3}};
+        constexpr auto sum = monad::fold(
+            [](int acc, int x) {return identity<int>{acc + x};},
+            0,
+            a
+        );
+        static_assert(sum.value() == 6, "");
+    }
+
+    auto check = [](int x) {
+        return checked<int>{x, {1, 0 <= x}};
+    };
+
+    // The primary template's bind() combines the states.
+    {
+        checked<int> const m = check(1);
+        auto const next = m >>= [&](int x) {return check(x + 1);};
+        BOOST_CHECK_EQUAL(next.value(), 2);
+        BOOST_CHECK((next.state() == checked_state{2, true}));
+
+        bool called = false;
+        auto const failed = check(-1) >>= [&](int x) {
+            called = true;
+            return check(x);
+        };
+        BOOST_CHECK(!called);
+        BOOST_CHECK(!failed.state().ok);
+
+        BOOST_CHECK(join(checked<checked<int>>{m, {1, true}}) == (checked<int>{1, {2, true}}));
+        BOOST_CHECK(checked<int>{5}.state().ok);
+    }
+
+    // Short-circuiting: f is not called after the first failure.
+    {
+        std::vector<int> const values = {1, 2, -3, 4, 5};
+        int calls = 0;
+        auto counted_check = [&](int x) {
+            ++calls;
+            return check(x);
+        };
+        auto const mapped = monad::map(counted_check, values);
+        BOOST_CHECK_EQUAL(calls, 3);
+        BOOST_CHECK((mapped.state() == checked_state{3, false}));
+
+        auto const good = monad::map(check, std::vector<int>{1, 2, 3});
+        BOOST_CHECK((good.value() == std::vector<int>{1, 2, 3}));
+        BOOST_CHECK((good.state() == checked_state{3, true}));
+
+        calls = 0;
+        BOOST_CHECK(!monad::map_(counted_check, values).state().ok);
+        BOOST_CHECK_EQUAL(calls, 3);
+
+        auto is_even = [](int x) {return checked<bool>{x % 2 == 0, {1, 0 <= x}};};
+        auto const evens = monad::filter(is_even, std::vector<int>{1, 2, 3, 4});
+        BOOST_CHECK((evens.value() == std::vector<int>{2, 4}));
+        BOOST_CHECK((evens.state() == checked_state{4, true}));
+
+        auto const t = monad::sequence(std::make_tuple(check(1), check(2)));
+        BOOST_CHECK((t.state() == checked_state{2, true}));
+    }
+
+    // The parallel path: each chunk is reduced in a loop, and the chunks'
+    // results are merged with combine().  checked_sum checks both of its
+    // operands, so that it is associative as a Kleisli operation, as
+    // reduce() requires.
+    {
+        auto checked_sum = [](long lhs, long rhs) {
+            return checked<long>{lhs + rhs, {1, 0 <= lhs && 0 <= rhs}};
+        };
+        std::vector<long> values(10000);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = i;
+        }
+        monad::parallel_policy four_threads = {4, 16};
+
+        auto const folded = monad::fold(checked_sum, 0l, values);
+        BOOST_CHECK((folded.state() == checked_state{10000, true}));
+        BOOST_CHECK(monad::reduce(four_threads, checked_sum, 0l, values) == folded);
+        BOOST_CHECK(monad::reduce(monad::seq, checked_sum, 0l, values) == folded);
+
+        // Failures inside a chunk, and at the first and last element of
+        // each chunk, which start at values.size() * i / 4.
+        std::vector<std::size_t> bad_indices = {777};
+        for (std::size_t i = 0; i < 4; ++i) {
+            bad_indices.push_back(values.size() * i / 4);
+            bad_indices.push_back(values.size() * (i + 1) / 4 - 1);
+        }
+        for (std::size_t index : bad_indices) {
+            std::vector<long> bad_values = values;
+            bad_values[index] = -1;
+            BOOST_CHECK(!monad::reduce(four_threads, checked_sum, 0l, bad_values).state().ok);
+            BOOST_CHECK(!monad::fold(checked_sum, 0l, bad_values).state().ok);
+        }
+    }
+
+    // A failure cancels the chunks before it too; the result must still
+    // hold the first failure, as fold()'s does.  The first chunk waits,
+    // before reaching its failure, until the last chunk has failed.
+    {
+        std::atomic<bool> wait = false;
+        std::atomic<bool> last_chunk_failed = false;
+        auto coded_sum = [&](long lhs, long rhs) {
+            if (wait && rhs == 2000) {
+                while (!last_chunk_failed) {
+                    std::this_thread::yield();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (lhs < 0 || rhs < 0) {
+                if (rhs == -2)
+                    last_chunk_failed = true;
+                return coded<long>{0, {static_cast<int>(lhs < 0 ? -lhs : -rhs)}};
+            }
+            return coded<long>{lhs + rhs};
+        };
+        std::vector<long> values(16384);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = i + 1;
+        }
+        values[3000] = -1;
+        values[12500] = -2;
+        monad::parallel_policy four_threads = {4, 4096};
+
+        BOOST_CHECK_EQUAL(monad::fold(coded_sum, 0l, values).state().code, 1);
+        wait = true;
+        BOOST_CHECK_EQUAL(monad::reduce(four_threads, coded_sum, 0l, values).state().code, 1);
+        wait = false;
+
+        values[3000] = 3001;
+        BOOST_CHECK_EQUAL(monad::reduce(four_threads, coded_sum, 0l, values).state().code, 2);
+        values[12500] = 12501;
+        auto const sum = monad::reduce(four_threads, coded_sum, 0l, values);
+        BOOST_CHECK_EQUAL(sum.state().code, 0);
+        BOOST_CHECK_EQUAL(sum.value(), 16384l * 16385 / 2);
+    }
+}
+
+namespace {
+
+    // A single-pass range of the integers [0, n), whose end is a sentinel,
+    // as with a generator.  Each element may be read only once.
+    struct counter
+    {
+        struct sentinel {};
+
+        struct iterator
+        {
+            using iterator_category = std::input_iterator_tag;
+            using value_type = int;
+            using difference_type = std::ptrdiff_t;
+            using pointer = int const *;
+            using reference = int const &;
+
+            counter * c;
+
+            int const & operator* () const
+            {
+                BOOST_CHECK(!c->read);
+                c->read = true;
+                return c->i;
+            }
+            iterator & operator++ ()
+            {
+                ++c->i;
+                c->read = false;
+                return *this;
+            }
+
+            friend bool operator== (iterator it, sentinel)
+            { return it.c->i == it.c->n; }
+            friend bool operator!= (iterator it, sentinel s)
+            { return !(it == s); }
+        };
+
+        iterator begin ()
+        { return iterator{this}; }
+
+        sentinel end ()
+        { return {}; }
+
+        int n;
+        int i = 0;
+        bool read = false;
+    };
+
+}
+
+BOOST_AUTO_TEST_CASE(streamed_algorithms)
+{
+    using monad::maybe;
+    using monad::span;
+
+    auto checked_negate = [](int x) {
+        return x == 13 ? maybe<long>{monad::nothing} : maybe<long>{-long(x)};
+    };
+
+    // The values arrive in order, in chunks of at most chunk_size, and only
+    // one chunk is held at a time.
+    std::vector<long> values;
+    std::size_t largest_chunk = 0;
+    auto sink = [&](span<long> chunk) {
+        largest_chunk = std::max(largest_chunk, chunk.size());
+        values.insert(values.end(), chunk.begin(), chunk.end());
+    };
+    counter ten{10};
+    BOOST_CHECK(monad::map(monad::streamed_policy{4}, checked_negate, ten, sink) == maybe<monad::unit>{monad::unit{}});
+    BOOST_CHECK(values == (std::vector<long>{0, -1, -2, -3, -4, -5, -6, -7, -8, -9}));
+    BOOST_CHECK_EQUAL(largest_chunk, 4u);
+
+    // Reading stops at the first failure; the values before it have been
+    // passed to the sink.
+    values.clear();
+    counter hundred{100};
+    BOOST_CHECK_EQUAL(monad::map(monad::streamed_policy{4}, checked_negate, hundred, sink), monad::nothing);
+    BOOST_CHECK_EQUAL(values.size(), 13u);
+    BOOST_CHECK_EQUAL(hundred.i, 14);
+
+    // The results of a streamed sequence() have the same values and state
+    // as those of sequence().
+    std::vector<maybe<long>> monads;
+    for (int i = 0; i < 50; ++i) {
+        monads.push_back(checked_negate(i));
+    }
+    std::vector<maybe<long>> const prefix(monads.begin(), monads.begin() + 13);
+    for (std::size_t chunk : {std::size_t(0), std::size_t(1), std::size_t(7)}) {
+        values.clear();
+        BOOST_CHECK(monad::sequence(monad::streamed_policy{chunk}, prefix, sink) == maybe<monad::unit>{monad::unit{}});
+        BOOST_CHECK(maybe<std::vector<long>>{values} == monad::sequence(prefix));
+        values.clear();
+        BOOST_CHECK_EQUAL(monad::sequence(monad::streamed_policy{chunk}, monads, sink), monad::nothing);
+        BOOST_CHECK(values == monad::sequence(monads).value());
+    }
+
+    // filter() and fold() read from a std::istream.
+    std::istringstream evens_in("4 8 15 16 23 42");
+    std::vector<int> evens;
+    auto is_even = [](int x) {return maybe<bool>{x % 2 == 0};};
+    BOOST_CHECK(
+        monad::filter(
+            monad::streamed_policy{2},
+            is_even,
+            std::istream_iterator<int>(evens_in),
+            std::istream_iterator<int>(),
+            [&](span<int> chunk) {evens.insert(evens.end(), chunk.begin(), chunk.end());}
+        ) == maybe<monad::unit>{monad::unit{}}
+    );
+    BOOST_CHECK(evens == (std::vector<int>{4, 8, 16, 42}));
+
+    // filter() reads each element once, whether or not it is kept.
+    std::vector<int> kept;
+    auto keep = [&](span<int> chunk) {kept.insert(kept.end(), chunk.begin(), chunk.end());};
+    counter twenty{20};
+    BOOST_CHECK(monad::filter(monad::streamed_policy{3}, is_even, twenty, keep) == maybe<monad::unit>{monad::unit{}});
+    BOOST_CHECK(kept == (std::vector<int>{0, 2, 4, 6, 8, 10, 12, 14, 16, 18}));
+
+    kept.clear();
+    auto checked_is_even = [](int x) {
+        return x == 13 ? maybe<bool>{monad::nothing} : maybe<bool>{x % 2 == 0};
+    };
+    counter thirty{30};
+    BOOST_CHECK_EQUAL(monad::filter(monad::streamed_policy{3}, checked_is_even, thirty, keep), monad::nothing);
+    BOOST_CHECK(kept == (std::vector<int>{0, 2, 4, 6, 8, 10, 12}));
+    BOOST_CHECK_EQUAL(thirty.i, 13);
+
+    auto bounded_sum = [](long acc, int x) {
+        return 100 < acc + x ? maybe<long>{monad::nothing} : maybe<long>{acc + x};
+    };
+    std::istringstream sum_in("4 8 15 16 23");
+    BOOST_CHECK_EQUAL(
+        monad::fold(
+            monad::streamed,
+            bounded_sum,
+            0l,
+            std::istream_iterator<int>(sum_in),
+            std::istream_iterator<int>()
+        ),
+        maybe<long>{66}
+    );
+    counter fifty{50};
+    BOOST_CHECK_EQUAL(monad::fold(monad::streamed, bounded_sum, 0l, fifty), monad::nothing);
+    BOOST_CHECK_EQUAL(fifty.i, 15);
+
+    counter empty{0};
+    BOOST_CHECK_EQUAL(monad::map(monad::streamed, checked_negate, empty, sink), monad::nothing);
+}
+
+BOOST_AUTO_TEST_CASE(bulk_sequence)
+{
+    using monad::maybe;
+
+    // Over contiguous maybes, sequence() scans the states in blocks, then
+    // copies the values.  Its results are the same as those of the
+    // element-by-element path taken over a std::list, for failures at and
+    // around the block boundaries.
+    for (int size : {1, 2, 255, 256, 257, 1000}) {
+        for (int failure : {-1, 0, 1, 254, 255, 256, 257, size - 1}) {
+            std::vector<maybe<int>> contiguous;
+            for (int i = 0; i < size; ++i) {
+                contiguous.push_back(i == failure ? maybe<int>{monad::nothing} : maybe<int>{i});
+            }
+            std::list<maybe<int>> const linked(contiguous.begin(), contiguous.end());
+            auto const bulk = monad::sequence(contiguous);
+            auto const generic = monad::sequence(linked.begin(), linked.end());
+            BOOST_CHECK(bulk.state() == generic.state());
+            BOOST_CHECK(bulk.value() == generic.value());
+            if (0 <= failure && failure < size)
+                BOOST_CHECK_EQUAL(bulk.value().size(), std::size_t(failure));
+            else
+                BOOST_CHECK(bulk.value().capacity() == std::size_t(size));
+        }
+    }
+
+    std::vector<monad::identity<double>> const identities = {1.0, 2.0, 3.0};
+    BOOST_CHECK(monad::sequence(identities).value() == (std::vector<double>{1.0, 2.0, 3.0}));
+
+    // map() with a projection returning a reference to a monad.
+    struct record
+    {
+        int key;
+        maybe<int> field;
+    };
+    std::vector<record> const records = {{1, {4}}, {2, {5}}, {3, monad::nothing}};
+    auto field = [](record const & r) -> maybe<int> const & {return r.field;};
+    BOOST_CHECK_EQUAL(monad::map(field, records.begin(), records.begin() + 2), (maybe<std::vector<int>>{{4, 5}}));
+    BOOST_CHECK_EQUAL(monad::map(field, records), monad::nothing);
+
+#if __cplusplus > 201703L
+    std::vector<maybe<int>> const ints = {1, 2, 3};
+    BOOST_CHECK_EQUAL(monad::map(std::identity{}, ints), (maybe<std::vector<int>>{{1, 2, 3}}));
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(validation)
+{
+    using monad::validated;
+
+    monad::error_arena arena(64);
+
+    auto positive = [&](std::string_view field, int x) {
+        return 0 < x ? monad::valid(x) : monad::invalid<int>(arena, field, "must be positive");
+    };
+    auto small = [&](std::string_view field, int x) {
+        return x < 100 ? monad::valid(x) : monad::invalid<int>(arena, field, "must be less than 100");
+    };
+    auto sum = [](int a, int b, int c) {return a + b + c;};
+
+    auto const all_valid = monad::lift_n<validated<int>>(sum, positive("a", 1), small("b", 2), positive("c", 3));
+    BOOST_CHECK(monad::is_valid(all_valid));
+    BOOST_CHECK_EQUAL(all_valid.value(), 6);
+    BOOST_CHECK(all_valid == monad::valid(6));
+
+    // Every failing argument is reported, in order, from one call.
+    auto const two_invalid = monad::lift_n<validated<int>>(sum, positive("a", -1), small("b", 2), small("c", 300));
+    BOOST_CHECK(!monad::is_valid(two_invalid));
+    std::vector<monad::validation_error> const expected = {
+        {"a", "must be positive"},
+        {"c", "must be less than 100"}
+    };
+    BOOST_CHECK(monad::errors(two_invalid) == expected);
+
+    // Errors accumulate across nested lift_n() calls and >>=, in order.
+    auto const nested = monad::lift_n<validated<int>>(
+        [](int x, int y) {return x * y;},
+        two_invalid,
+        positive("d", 0)
+    ) >>= [&](int x) {return small("e", x + 1000);};
+    auto const nested_errors = monad::errors(nested);
+    BOOST_REQUIRE_EQUAL(nested_errors.size(), 4u);
+    BOOST_CHECK_EQUAL(nested_errors[0].field, "a");
+    BOOST_CHECK_EQUAL(nested_errors[1].field, "c");
+    BOOST_CHECK_EQUAL(nested_errors[2].field, "d");
+    BOOST_CHECK_EQUAL(nested_errors[3].field, "e");
+
+    // Messages built at run time are copied into the arena, including ones
+    // larger than its blocks.
+    std::string const long_message(200, 'x');
+    auto const copied = monad::invalid<int>(arena, "f", arena.copy(long_message));
+    BOOST_CHECK_EQUAL(monad::errors(copied)[0].message, long_message);
+
+    // map() and zip() check every element, sequentially or in parallel.
+    std::vector<int> inputs(1000);
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i] = int(i) % 250 == 7 ? -1 : int(i);
+    }
+    auto check = [&](int x) {return positive("x", x);};
+    auto const sequential = monad::map(check, inputs);
+    BOOST_CHECK_EQUAL(monad::error_count(sequential), 5u); // 0, 7, 257, 507 and 757
+    monad::parallel_policy const four_threads = {4, 16};
+    auto const parallel = monad::map(four_threads, check, inputs);
+    BOOST_CHECK(parallel == sequential);
+    BOOST_CHECK_EQUAL(parallel.value().size(), inputs.size());
+
+    auto both_small = [&](int x, int y) {
+        return monad::lift_n<validated<int>>(std::plus<int>{}, small("x", x), small("y", y));
+    };
+    auto const zipped = monad::zip(four_threads, both_small, inputs, inputs);
+    BOOST_CHECK(zipped == monad::zip(both_small, inputs, inputs));
+    BOOST_CHECK_EQUAL(monad::error_count(zipped), 2 * (900u - 3)); // [100, 1000) but -1s
+
+    // The parallel map() gives the same results as map() for maybe.
+    using monad::maybe;
+    auto halve = [](int x) {
+        return x % 2 ? maybe<int>{monad::nothing} : maybe<int>{x / 2};
+    };
+    std::vector<int> evens(1000);
+    for (std::size_t i = 0; i < evens.size(); ++i) {
+        evens[i] = 2 * int(i);
+    }
+    BOOST_CHECK(monad::map(four_threads, halve, evens) == monad::map(halve, evens));
+    evens[600] = 3;
+    BOOST_CHECK(monad::map(four_threads, halve, evens) == monad::map(halve, evens));
+    BOOST_CHECK_EQUAL(monad::map(four_threads, halve, evens).value().size(), 600u);
+
+    arena.clear();
+    BOOST_CHECK(monad::is_valid(monad::lift_n<validated<int>>(sum, positive("a", 1), small("b", 2), positive("c", 3))));
+}
@@ -0,0 +1,283 @@
+#ifndef VALIDATION_HPP_INCLUDED_
+#define VALIDATION_HPP_INCLUDED_
+
+#include <monad_core.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <vector>
+
+
+namespace monad {
+
+    /** One failed check: the field that failed it, and why. */
+    struct validation_error
+    {
+        std::string_view field;
+        std::string_view message;
+    };
+
+    inline bool operator== (validation_error const & lhs, validation_error const & rhs)
+    { return lhs.field == rhs.field && lhs.message == rhs.message; }
+
+    inline bool operator!= (validation_error const & lhs, validation_error const & rhs)
+    { return !(lhs == rhs); }
+
+    class error_arena;
+
+    namespace detail {
+
+        // A node of an error list.  A leaf holds one error; any other node
+        // is the concatenation of left and right, so that two lists are
+        // combined with one allocation, whatever their lengths.  Each node
+        // records the length of its list and the arena that holds it, so
+        // that a validation's state is a single pointer.
+        struct error_node
+        {
+            error_node const * left;
+            error_node const * right;
+            std::size_t size;
+            error_arena * arena;
+            validation_error error;
+        };
+
+    }
+
+    /** A monotonic arena in which validations allocate their errors.  Valid
+        results allocate nothing; each error, and each combination of two
+        nonempty error lists, allocates one small node.  Nothing is freed
+        until the arena is cleared or destroyed, so the arena must outlive
+        every validated value whose errors it holds.  Allocation is
+        thread-safe, so that validations may run in parallel. */
+    class error_arena
+    {
+    public:
+        explicit error_arena (std::size_t block_size = 4096) :
+            block_size_ (std::max(block_size, sizeof(detail::error_node))),
+            used_ (0)
+        {}
+
+        error_arena (error_arena const &) = delete;
+        error_arena & operator= (error_arena const &) = delete;
+
+        /** Copies @c s into the arena, for error messages that are built at
+            run time rather than string literals. */
+        std::string_view copy (std::string_view s)
+        {
+            if (s.empty())
+                return s;
+            char * p = static_cast<char *>(allocate(s.size(), 1));
+            std::memcpy(p, s.data(), s.size());
+            return std::string_view(p, s.size());
+        }
+
+        /** Frees everything allocated so far.  The errors of any validated
+            values created with this arena may no longer be read. */
+        void clear ()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (1 < blocks_.size())
+                blocks_.erase(blocks_.begin() + 1, blocks_.end());
+            used_ = 0;
+        }
+
+        detail::error_node const * make_leaf (validation_error error)
+        {
+            return new (allocate(sizeof(detail::error_node), alignof(detail::error_node)))
+                detail::error_node{nullptr, nullptr, 1, this, error};
+        }
+
+        detail::error_node const *
+        make_concatenation (detail::error_node const * left, detail::error_node const * right)
+        {
+            return new (allocate(sizeof(detail::error_node), alignof(detail::error_node)))
+                detail::error_node{
+                    left,
+                    right,
+                    left->size + right->size,
+                    this,
+                    validation_error{}
+                };
+        }
+
+    private:
+        // Kept out of line, so that a validation that may fail stays small
+        // enough to be inlined where it succeeds.
+#if defined(_MSC_VER)
+        __declspec(noinline)
+#elif defined(__GNUC__)
+        __attribute__((noinline))
+#endif
+        void * allocate (std::size_t size, std::size_t alignment)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (block_size_ < size) {
+                // An oversized allocation gets a block of its own, placed
+                // before the one being filled.
+                auto const it = blocks_.insert(
+                    blocks_.empty() ? blocks_.end() : blocks_.end() - 1,
+                    std::unique_ptr<char[]>(new char[size])
+                );
+                if (blocks_.size() == 1)
+                    used_ = block_size_;
+                return it->get();
+            }
+            std::size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+            if (blocks_.empty() || block_size_ < offset + size) {
+                blocks_.emplace_back(new char[block_size_]);
+                offset = 0;
+            }
+            used_ = offset + size;
+            return blocks_.back().get() + offset;
+        }
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        std::size_t block_size_;
+        std::size_t used_;
+        std::mutex mutex_;
+    };
+
+    namespace detail {
+
+        // The errors of a validation, or null if there are none, as in the
+        // value-initialized state.
+        struct validation_state
+        {
+            error_node const * errors;
+        };
+
+        inline std::size_t error_count (validation_state state)
+        { return state.errors ? state.errors->size : 0; }
+
+        // Calls f on each error of the list rooted at node, in order.
+        template <typename Fn>
+        void for_each_error (error_node const * node, Fn f)
+        {
+            if (!node)
+                return;
+            // The right subtrees not yet visited.  A list of n errors is at
+            // most n - 1 levels deep.
+            std::vector<error_node const *> pending;
+            while (true) {
+                while (node->left) {
+                    pending.push_back(node->right);
+                    node = node->left;
+                }
+                f(node->error);
+                if (pending.empty())
+                    return;
+                node = pending.back();
+                pending.pop_back();
+            }
+        }
+
+        inline bool operator== (validation_state const & lhs, validation_state const & rhs)
+        {
+            if (error_count(lhs) != error_count(rhs))
+                return false;
+            std::vector<validation_error> lhs_errors;
+            lhs_errors.reserve(error_count(lhs));
+            for_each_error(lhs.errors, [&](validation_error const & e) {
+                lhs_errors.push_back(e);
+            });
+            std::size_t i = 0;
+            bool retval = true;
+            for_each_error(rhs.errors, [&](validation_error const & e) {
+                retval = retval && lhs_errors[i++] == e;
+            });
+            return retval;
+        }
+
+    }
+
+    /** A validation's state accumulates errors rather than stopping at the
+        first: combining two states concatenates their error lists, in
+        order, with a single arena allocation. */
+    template <>
+    struct monad_traits<detail::validation_state> :
+        default_monad_traits<detail::validation_state>
+    {
+        static constexpr bool state_independent_of_values = true;
+        static constexpr bool associative_combine = true;
+
+        static detail::validation_state
+        combine (detail::validation_state const & lhs, detail::validation_state const & rhs)
+        {
+            if (!lhs.errors)
+                return rhs;
+            if (!rhs.errors)
+                return lhs;
+            return detail::validation_state{
+                lhs.errors->arena->make_concatenation(lhs.errors, rhs.errors)
+            };
+        }
+    };
+
+    /** The result of validating a T: a T, or the errors found in the
+        attempt.  Unlike maybe, a validated does not stop at a failure;
+        lift_n(), sequence(), map(), zip() and the other algorithms combine
+        the states of all their arguments, so that a single pass reports
+        every failed check.  To do so, functions are called on the values
+        of failed validations too, which are placeholders (by default
+        value-initialized), so T must be default constructible and the
+        functions must accept any T.  The value of a validated is
+        meaningful only if it has no errors.
+
+        This makes validated an applicative functor rather than a monad;
+        >>= works, but a bound function cannot see whether the value it is
+        passed is a placeholder. */
+    template <typename T>
+    using validated = monad<T, detail::validation_state>;
+
+    /** Returns a validated with value @c x and no errors. */
+    template <typename T>
+    validated<T> valid (T x)
+    { return validated<T>{std::move(x)}; }
+
+    /** Returns a validated with the single error <c>{field, message}</c>,
+        allocated in @c arena, and the placeholder value @c placeholder. */
+    template <typename T>
+    validated<T> invalid (
+        error_arena & arena,
+        std::string_view field,
+        std::string_view message,
+        T placeholder = T()
+    ) {
+        return validated<T>{
+            std::move(placeholder),
+            detail::validation_state{arena.make_leaf(validation_error{field, message})}
+        };
+    }
+
+    /** Returns true if @c v has no errors. */
+    template <typename T>
+    bool is_valid (validated<T> const & v)
+    { return !v.state().errors; }
+
+    /** Returns the number of errors of @c v. */
+    template <typename T>
+    std::size_t error_count (validated<T> const & v)
+    { return detail::error_count(v.state()); }
+
+    /** Returns the errors of @c v, in the order of the validations that
+        found them. */
+    template <typename T>
+    std::vector<validation_error> errors (validated<T> const & v)
+    {
+        std::vector<validation_error> retval;
+        retval.reserve(error_count(v));
+        detail::for_each_error(
+            v.state().errors,
+            [&retval](validation_error const & e) {retval.push_back(e);}
+        );
+        return retval;
+    }
+
+}
+
+#endif